@@ -0,0 +1,101 @@
+#include "AsyncLogger.h"
+
+#include <iostream>
+
+
+void AsyncLogger::Start ()
+{
+	Stop ();
+
+	stopping = false;
+	worker = std::thread (&AsyncLogger::WorkerLoop, this);
+}
+
+
+void AsyncLogger::Stop ()
+{
+	if (!worker.joinable ()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock (queueMutex);
+		stopping = true;
+	}
+	queueChanged.notify_one ();
+	worker.join ();
+}
+
+
+AsyncLogger::~AsyncLogger ()
+{
+	Stop ();
+}
+
+
+void AsyncLogger::Write (LogStream stream, std::string line)
+{
+	{
+		std::lock_guard<std::mutex> lock (queueMutex);
+		if (worker.joinable () && !stopping) {
+			queue.push_back ({stream, std::move (line)});
+			queueChanged.notify_one ();
+			return;
+		}
+	}
+
+	WriteLines ({{stream, std::move (line)}});
+}
+
+
+void AsyncLogger::WorkerLoop ()
+{
+	std::vector<LogLine> lines;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock (queueMutex);
+			queueChanged.wait (lock, [this] () { return !queue.empty () || stopping; });
+			if (queue.empty ()) {
+				return;
+			}
+			// the lock only covers the swap, writers never wait for the terminal
+			lines.swap (queue);
+		}
+
+		WriteLines (lines);
+		lines.clear ();
+	}
+}
+
+
+void AsyncLogger::WriteLines (const std::vector<LogLine>& lines)
+{
+	bool wroteOut = false;
+	bool wroteError = false;
+
+	for (const auto& line : lines) {
+		if (line.stream == LogStream::Error) {
+			std::cerr << line.text << '\n';
+			wroteError = true;
+		} else {
+			std::cout << line.text << '\n';
+			wroteOut = true;
+		}
+	}
+
+	// one flush per batch rather than per line
+	if (wroteOut) {
+		std::cout.flush ();
+	}
+	if (wroteError) {
+		std::cerr.flush ();
+	}
+}
+
+
+AsyncLogger& GetLogger ()
+{
+	static AsyncLogger logger;
+	return logger;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_ASYNCLOGGER_H
+#define VULKANPROJECT_I_ASYNCLOGGER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+enum class LogStream {
+	Out,
+	Error
+};
+
+
+// log lines are queued and written to the terminal by a worker thread, so the render and input
+// threads never wait on a console flush. Before Start and after Stop lines are written directly
+class AsyncLogger
+{
+public:
+	AsyncLogger () = default;
+	AsyncLogger (const AsyncLogger&) = delete;
+	AsyncLogger& operator= (const AsyncLogger&) = delete;
+
+	void Start ();
+	// writes everything already queued, then stops
+	void Stop ();
+
+	// one complete line, without the newline
+	void Write (LogStream stream, std::string line);
+
+	~AsyncLogger ();
+
+private:
+	struct LogLine {
+		LogStream stream;
+		std::string text;
+	};
+
+	std::thread worker;
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::vector<LogLine> queue;
+	bool stopping = false;
+
+	void WorkerLoop ();
+	static void WriteLines (const std::vector<LogLine>& lines);
+};
+
+
+// the process wide logger
+AsyncLogger& GetLogger ();
+
+// streams the arguments into one line, e.g. Log (LogStream::Out, "Key> ", key)
+template <typename... Arguments>
+void Log (LogStream stream, const Arguments&... arguments)
+{
+	std::ostringstream line;
+	(line << ... << arguments);
+	GetLogger ().Write (stream, line.str ());
+}
+
+
+#endif //VULKANPROJECT_I_ASYNCLOGGER_H
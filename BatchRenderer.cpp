@@ -0,0 +1,194 @@
+#include "BatchRenderer.h"
+
+#include <exception>
+#include <thread>
+
+
+int BatchRenderer::Init (uint32_t width, uint32_t height, bool includeSoftwareDevices)
+{
+	std::vector<PhysicalDeviceInfo> physicalDevices;
+	try {
+		physicalDevices = QueryPhysicalDevices ();
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Error: " << runtimeError.what () << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (const auto& physicalDevice : physicalDevices) {
+		if (!includeSoftwareDevices && physicalDevice.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+			continue;
+		}
+
+		auto device = std::make_unique<Device> ();
+		device->name = physicalDevice.properties.deviceName;
+		device->renderer = std::make_unique<VulkanRenderer> ();
+		device->renderer->SetDeviceOverride (MakeDeviceOverride (physicalDevice));
+
+		if (device->renderer->InitHeadless (width, height) == EXIT_FAILURE) {
+			std::cerr << "Batch> skipping " << DescribePhysicalDevice (physicalDevice) << std::endl;
+			continue;
+		}
+
+		devices.push_back (std::move (device));
+	}
+
+	if (devices.empty ()) {
+		std::cerr << "Error: No device could be set up for batch rendering..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return 0;
+}
+
+
+void BatchRenderer::Render (const std::vector<BatchJob>& jobs, const FrameConsumer& consumer)
+{
+	frames.assign (jobs.size (), Image {});
+	framesDone.assign (jobs.size (), 0);
+
+	// round robin up front, stealing evens out devices of different speed afterwards
+	std::vector<size_t> healthyDevices;
+	for (size_t i = 0; i < devices.size (); ++i) {
+		devices[i]->jobsRendered = 0;
+		// a Render cancelled by its consumer may have left jobs behind
+		devices[i]->jobQueue.clear ();
+		if (!devices[i]->failed) {
+			healthyDevices.push_back (i);
+		}
+	}
+	if (healthyDevices.empty ()) {
+		throw std::runtime_error ("Every batch rendering device has failed...");
+	}
+	for (size_t jobIndex = 0; jobIndex < jobs.size (); ++jobIndex) {
+		devices[healthyDevices[jobIndex % healthyDevices.size ()]]->jobQueue.push_back (jobIndex);
+	}
+
+	size_t nextFrame = 0;
+	while (nextFrame < jobs.size ()) {
+		std::vector<std::thread> workers;
+		{
+			std::lock_guard<std::mutex> lock (frameMutex);
+			for (size_t i = 0; i < devices.size (); ++i) {
+				if (!devices[i]->failed) {
+					++activeWorkers;
+					workers.emplace_back (&BatchRenderer::WorkerLoop, this, i, std::cref (jobs));
+				}
+			}
+		}
+
+		if (workers.empty ()) {
+			throw std::runtime_error ("Every batch rendering device has failed...");
+		}
+
+		// hand frames over in order as soon as they are contiguous, and free them right after
+		std::exception_ptr consumerError;
+		while (nextFrame < jobs.size ()) {
+			Image frame;
+			{
+				std::unique_lock<std::mutex> lock (frameMutex);
+				frameReady.wait (lock, [this, nextFrame] () { return framesDone[nextFrame] != 0 || activeWorkers == 0; });
+				if (framesDone[nextFrame] == 0) {
+					break;
+				}
+				frame = std::move (frames[nextFrame]);
+			}
+
+			try {
+				consumer (nextFrame, frame);
+			} catch (...) {
+				consumerError = std::current_exception ();
+				break;
+			}
+			++nextFrame;
+		}
+
+		// the workers finish the job they are on, unwinding past joinable threads would terminate
+		if (consumerError) {
+			cancelled = true;
+		}
+		for (auto& worker : workers) {
+			worker.join ();
+		}
+		if (consumerError) {
+			cancelled = false;
+			std::rethrow_exception (consumerError);
+		}
+
+		// jobs left behind by a device that failed mid batch are stolen by the others next round
+	}
+}
+
+
+void BatchRenderer::WorkerLoop (size_t deviceIndex, const std::vector<BatchJob>& jobs)
+{
+	Device& device = *devices[deviceIndex];
+
+	size_t jobIndex;
+	while (TakeJob (deviceIndex, jobIndex)) {
+		Image frame;
+		try {
+			jobs[jobIndex].setUp (*device.renderer);
+			device.renderer->Update ();
+			device.renderer->Draw ();
+			device.renderer->CaptureFrame (frame);
+		} catch (const std::exception& exception) {
+			std::cerr << "Batch> " << device.name << " failed job " << jobIndex << ": " << exception.what () << std::endl;
+
+			std::lock_guard<std::mutex> queueLock (device.queueMutex);
+			device.jobQueue.push_front (jobIndex);
+			device.failed = true;
+			break;
+		}
+
+		++device.jobsRendered;
+
+		std::lock_guard<std::mutex> lock (frameMutex);
+		frames[jobIndex] = std::move (frame);
+		framesDone[jobIndex] = 1;
+		frameReady.notify_one ();
+	}
+
+	std::lock_guard<std::mutex> lock (frameMutex);
+	--activeWorkers;
+	frameReady.notify_one ();
+}
+
+
+bool BatchRenderer::TakeJob (size_t deviceIndex, size_t& jobIndex)
+{
+	if (cancelled) {
+		return false;
+	}
+
+	{
+		Device& device = *devices[deviceIndex];
+		std::lock_guard<std::mutex> lock (device.queueMutex);
+		if (!device.jobQueue.empty ()) {
+			jobIndex = device.jobQueue.front ();
+			device.jobQueue.pop_front ();
+			return true;
+		}
+	}
+
+	// steal from the back, the work the victim would get to last
+	for (size_t offset = 1; offset < devices.size (); ++offset) {
+		Device& victim = *devices[(deviceIndex + offset) % devices.size ()];
+		std::lock_guard<std::mutex> lock (victim.queueMutex);
+		if (!victim.jobQueue.empty ()) {
+			jobIndex = victim.jobQueue.back ();
+			victim.jobQueue.pop_back ();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void BatchRenderer::CleanUp ()
+{
+	for (auto& device : devices) {
+		device->renderer->CleanUp ();
+	}
+	devices.clear ();
+}
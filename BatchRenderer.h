@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_BATCHRENDERER_H
+#define VULKANPROJECT_I_BATCHRENDERER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "VulkanRenderer.h"
+
+
+struct BatchJob {
+	// has to set up everything the frame depends on, the device may have rendered any other job before
+	std::function<void (VulkanRenderer&)> setUp;
+};
+
+
+// offline rendering over every GPU in the machine: one headless renderer, logical device and
+// worker thread per physical device, jobs spread with work stealing and handed back in order
+class BatchRenderer
+{
+public:
+	using FrameConsumer = std::function<void (size_t jobIndex, const Image& image)>;
+
+	// software devices such as lavapipe are useful for testing but slow real GPUs down in a mix
+	int Init (uint32_t width, uint32_t height, bool includeSoftwareDevices = true);
+	// blocks until every job is rendered; consumer runs on the calling thread, in job order,
+	// while later jobs are still rendering. If consumer throws, the jobs not yet started are
+	// dropped and the exception is rethrown once the workers have stopped
+	void Render (const std::vector<BatchJob>& jobs, const FrameConsumer& consumer);
+	void CleanUp ();
+
+	size_t GetDeviceCount () const { return devices.size (); }
+	const std::string& GetDeviceName (size_t deviceIndex) const { return devices[deviceIndex]->name; }
+	// from the last Render, to see how the work spread over the devices
+	size_t GetJobsRendered (size_t deviceIndex) const { return devices[deviceIndex]->jobsRendered; }
+
+private:
+	struct Device {
+		std::string name;
+		std::unique_ptr<VulkanRenderer> renderer;
+		// owner takes from the front, thieves from the back
+		std::deque<size_t> jobQueue;
+		std::mutex queueMutex;
+		size_t jobsRendered = 0;
+		bool failed = false;
+	};
+
+	std::vector<std::unique_ptr<Device>> devices;
+
+	std::mutex frameMutex;
+	std::condition_variable frameReady;
+	std::vector<Image> frames;
+	std::vector<uint8_t> framesDone;
+	size_t activeWorkers = 0;
+	// set when the consumer has thrown, workers stop taking jobs
+	std::atomic<bool> cancelled {false};
+
+	void WorkerLoop (size_t deviceIndex, const std::vector<BatchJob>& jobs);
+	bool TakeJob (size_t deviceIndex, size_t& jobIndex);
+};
+
+
+#endif //VULKANPROJECT_I_BATCHRENDERER_H
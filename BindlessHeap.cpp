@@ -0,0 +1,179 @@
+#include "BindlessHeap.h"
+
+#include <array>
+#include <stdexcept>
+
+
+void BindlessHeap::Create (VkDevice newDevice, const VkAllocationCallbacks* newAllocator, uint32_t textureCapacity, uint32_t bufferCapacity)
+{
+	device = newDevice;
+	allocator = newAllocator;
+	textureIndices.Reset (textureCapacity);
+	bufferIndices.Reset (bufferCapacity);
+
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+	bindings[0].binding = TextureBinding;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = textureCapacity;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].binding = BufferBinding;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = bufferCapacity;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	// most of the set is never written, and what is written changes while the set stays bound
+	VkDescriptorBindingFlags bindingFlag = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+										   VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+										   VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+	std::array<VkDescriptorBindingFlags, 2> bindingFlags = {bindingFlag, bindingFlag};
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo {};
+	bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsCreateInfo.bindingCount = static_cast<uint32_t> (bindingFlags.size ());
+	bindingFlagsCreateInfo.pBindingFlags = bindingFlags.data ();
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo {};
+	setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+	setLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	setLayoutCreateInfo.bindingCount = static_cast<uint32_t> (bindings.size ());
+	setLayoutCreateInfo.pBindings = bindings.data ();
+
+	VkResult result = vkCreateDescriptorSetLayout (device, &setLayoutCreateInfo, allocator, &setLayout);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create the bindless descriptor set layout...");
+	}
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = textureCapacity;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = bufferCapacity;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t> (poolSizes.size ());
+	poolCreateInfo.pPoolSizes = poolSizes.data ();
+
+	result = vkCreateDescriptorPool (device, &poolCreateInfo, allocator, &descriptorPool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create the bindless descriptor pool...");
+	}
+
+	VkDescriptorSetAllocateInfo setAllocateInfo {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = 1;
+	setAllocateInfo.pSetLayouts = &setLayout;
+
+	result = vkAllocateDescriptorSets (device, &setAllocateInfo, &descriptorSet);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate the bindless descriptor set...");
+	}
+}
+
+
+void BindlessHeap::Destroy ()
+{
+	if (descriptorPool != VK_NULL_HANDLE) {
+		vkDestroyDescriptorPool (device, descriptorPool, allocator);
+		descriptorPool = VK_NULL_HANDLE;
+		descriptorSet = VK_NULL_HANDLE;
+	}
+	if (setLayout != VK_NULL_HANDLE) {
+		vkDestroyDescriptorSetLayout (device, setLayout, allocator);
+		setLayout = VK_NULL_HANDLE;
+	}
+}
+
+
+uint32_t BindlessHeap::AddTexture (VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+{
+	uint32_t index = textureIndices.Allocate ();
+
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet descriptorWrite {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = TextureBinding;
+	descriptorWrite.dstArrayElement = index;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets (device, 1, &descriptorWrite, 0, nullptr);
+
+	return index;
+}
+
+
+uint32_t BindlessHeap::AddBuffer (VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	uint32_t index = bufferIndices.Allocate ();
+
+	VkDescriptorBufferInfo bufferInfo {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet descriptorWrite {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = BufferBinding;
+	descriptorWrite.dstArrayElement = index;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets (device, 1, &descriptorWrite, 0, nullptr);
+
+	return index;
+}
+
+
+void BindlessHeap::Collect (uint64_t completedSerial)
+{
+	textureIndices.Collect (completedSerial);
+	bufferIndices.Collect (completedSerial);
+}
+
+
+void BindlessHeap::IndexAllocator::Reset (uint32_t newCapacity)
+{
+	capacity = newCapacity;
+	nextUnused = 0;
+	freeIndices.clear ();
+	pending.clear ();
+}
+
+
+uint32_t BindlessHeap::IndexAllocator::Allocate ()
+{
+	if (!freeIndices.empty ()) {
+		uint32_t index = freeIndices.back ();
+		freeIndices.pop_back ();
+		return index;
+	}
+
+	if (nextUnused == capacity) {
+		throw std::runtime_error ("The bindless heap is full...");
+	}
+
+	return nextUnused++;
+}
+
+
+void BindlessHeap::IndexAllocator::Collect (uint64_t completedSerial)
+{
+	// released in submission order, so the front is always the oldest
+	while (!pending.empty () && pending.front ().serial <= completedSerial) {
+		freeIndices.push_back (pending.front ().index);
+		pending.pop_front ();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_BINDLESSHEAP_H
+#define VULKANPROJECT_I_BINDLESSHEAP_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+// one update-after-bind descriptor set holding every texture and storage buffer, bound once per
+// command buffer; shaders pick entries by the indices each draw pushes (Vulkan 1.2 descriptor indexing)
+class BindlessHeap
+{
+public:
+	// binding numbers in the set, shaders declare the arrays with the same ones
+	static constexpr uint32_t TextureBinding = 0;
+	static constexpr uint32_t BufferBinding = 1;
+
+	void Create (VkDevice newDevice, const VkAllocationCallbacks* newAllocator, uint32_t textureCapacity, uint32_t bufferCapacity);
+	void Destroy ();
+	bool IsCreated () const { return descriptorSet != VK_NULL_HANDLE; }
+
+	// new entries are written straight into the bound set; that is legal while frames are in flight
+	// because no pending frame can be using an index that was free
+	uint32_t AddTexture (VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout);
+	uint32_t AddBuffer (VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+	// the index is handed out again once the frame with this serial has completed
+	void RemoveTexture (uint32_t index, uint64_t serial) { textureIndices.Release (index, serial); }
+	void RemoveBuffer (uint32_t index, uint64_t serial) { bufferIndices.Release (index, serial); }
+	void Collect (uint64_t completedSerial);
+
+	VkDescriptorSetLayout GetSetLayout () const { return setLayout; }
+	VkDescriptorSet GetDescriptorSet () const { return descriptorSet; }
+
+private:
+	class IndexAllocator
+	{
+	public:
+		void Reset (uint32_t newCapacity);
+		// throws once every index is taken
+		uint32_t Allocate ();
+		void Release (uint32_t index, uint64_t serial) { pending.push_back ({index, serial}); }
+		void Collect (uint64_t completedSerial);
+
+	private:
+		struct PendingIndex {
+			uint32_t index;
+			uint64_t serial;
+		};
+
+		uint32_t capacity = 0;
+		uint32_t nextUnused = 0;
+		std::vector<uint32_t> freeIndices;
+		std::deque<PendingIndex> pending;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	const VkAllocationCallbacks* allocator = nullptr;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+	IndexAllocator textureIndices;
+	IndexAllocator bufferIndices;
+};
+
+
+#endif //VULKANPROJECT_I_BINDLESSHEAP_H
@@ -0,0 +1,43 @@
+#include "DeletionQueue.h"
+
+#include <limits>
+
+
+template <typename Handle, typename DestroyFunction>
+void DeletionQueue::CollectList (PendingList<Handle>& pendingList, uint64_t completedSerial, DestroyFunction destroy)
+{
+	// serials are pushed in submission order, so the front is always the oldest
+	while (!pendingList.empty () && pendingList.front ().serial <= completedSerial) {
+		destroy (device, pendingList.front ().handle, allocator);
+		pendingList.pop_front ();
+	}
+}
+
+
+void DeletionQueue::Collect (uint64_t completedSerial)
+{
+	// dependents go before the objects they reference
+	CollectList (pipelines, completedSerial, vkDestroyPipeline);
+	CollectList (pipelineLayouts, completedSerial, vkDestroyPipelineLayout);
+	CollectList (descriptorPools, completedSerial, vkDestroyDescriptorPool);
+	CollectList (shaderModules, completedSerial, vkDestroyShaderModule);
+	CollectList (framebuffers, completedSerial, vkDestroyFramebuffer);
+	CollectList (imageViews, completedSerial, vkDestroyImageView);
+	CollectList (swapchains, completedSerial, vkDestroySwapchainKHR);
+	CollectList (images, completedSerial, vkDestroyImage);
+	CollectList (buffers, completedSerial, vkDestroyBuffer);
+	CollectList (memories, completedSerial, vkFreeMemory);
+}
+
+
+void DeletionQueue::Flush ()
+{
+	Collect (std::numeric_limits<uint64_t>::max ());
+}
+
+
+size_t DeletionQueue::GetPendingCount () const
+{
+	return pipelines.size () + pipelineLayouts.size () + descriptorPools.size () + shaderModules.size () + framebuffers.size () +
+		   imageViews.size () + swapchains.size () + images.size () + buffers.size () + memories.size ();
+}
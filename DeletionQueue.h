@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_DELETIONQUEUE_H
+#define VULKANPROJECT_I_DELETIONQUEUE_H
+
+#include <cstdint>
+#include <deque>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+// holds resources until the frame serial that last used them has completed on the GPU,
+// so runtime resource changes never need vkDeviceWaitIdle
+class DeletionQueue
+{
+public:
+	// objects are destroyed with allocator, which has to be the one they were created with
+	void Init (VkDevice newDevice, const VkAllocationCallbacks* newAllocator = nullptr)
+	{
+		device = newDevice;
+		allocator = newAllocator;
+	}
+
+	void Push (VkPipeline pipeline, uint64_t serial) { pipelines.push_back ({pipeline, serial}); }
+	void Push (VkPipelineLayout pipelineLayout, uint64_t serial) { pipelineLayouts.push_back ({pipelineLayout, serial}); }
+	void Push (VkDescriptorPool descriptorPool, uint64_t serial) { descriptorPools.push_back ({descriptorPool, serial}); }
+	void Push (VkShaderModule shaderModule, uint64_t serial) { shaderModules.push_back ({shaderModule, serial}); }
+	void Push (VkFramebuffer framebuffer, uint64_t serial) { framebuffers.push_back ({framebuffer, serial}); }
+	void Push (VkImageView imageView, uint64_t serial) { imageViews.push_back ({imageView, serial}); }
+	void Push (VkSwapchainKHR swapchain, uint64_t serial) { swapchains.push_back ({swapchain, serial}); }
+	void Push (VkImage image, uint64_t serial) { images.push_back ({image, serial}); }
+	void Push (VkBuffer buffer, uint64_t serial) { buffers.push_back ({buffer, serial}); }
+	void Push (VkDeviceMemory memory, uint64_t serial) { memories.push_back ({memory, serial}); }
+
+	// destroys everything whose serial is at or below completedSerial
+	void Collect (uint64_t completedSerial);
+	// destroys everything, only valid once the device is idle
+	void Flush ();
+
+	size_t GetPendingCount () const;
+
+private:
+	template <typename Handle>
+	struct Pending {
+		Handle handle;
+		uint64_t serial;
+	};
+
+	template <typename Handle>
+	using PendingList = std::deque<Pending<Handle>>;
+
+	VkDevice device = VK_NULL_HANDLE;
+	const VkAllocationCallbacks* allocator = nullptr;
+
+	PendingList<VkPipeline> pipelines;
+	PendingList<VkPipelineLayout> pipelineLayouts;
+	PendingList<VkDescriptorPool> descriptorPools;
+	PendingList<VkShaderModule> shaderModules;
+	PendingList<VkFramebuffer> framebuffers;
+	PendingList<VkImageView> imageViews;
+	PendingList<VkSwapchainKHR> swapchains;
+	PendingList<VkImage> images;
+	PendingList<VkBuffer> buffers;
+	PendingList<VkDeviceMemory> memories;
+
+	template <typename Handle, typename DestroyFunction>
+	void CollectList (PendingList<Handle>& pendingList, uint64_t completedSerial, DestroyFunction destroy);
+};
+
+
+#endif //VULKANPROJECT_I_DELETIONQUEUE_H
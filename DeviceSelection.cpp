@@ -0,0 +1,237 @@
+#include "DeviceSelection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+
+PhysicalDeviceInfo GetPhysicalDeviceInfo (VkPhysicalDevice device, uint32_t index, uint32_t instanceApiVersion)
+{
+	PhysicalDeviceInfo info {};
+	info.device = device;
+	info.index = index;
+	vkGetPhysicalDeviceProperties (device, &info.properties);
+
+	if (instanceApiVersion >= VK_API_VERSION_1_1 && info.properties.apiVersion >= VK_API_VERSION_1_1) {
+		VkPhysicalDeviceIDProperties idProperties {};
+		idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2 {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &idProperties;
+		vkGetPhysicalDeviceProperties2 (device, &properties2);
+
+		info.hasUuid = true;
+		std::copy (std::begin (idProperties.deviceUUID), std::end (idProperties.deviceUUID), info.uuid.begin ());
+	}
+
+	if (instanceApiVersion >= VK_API_VERSION_1_2 && info.properties.apiVersion >= VK_API_VERSION_1_2) {
+		VkPhysicalDeviceVulkan12Features vulkan12Features {};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features2 {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &vulkan12Features;
+		vkGetPhysicalDeviceFeatures2 (device, &features2);
+
+		info.timelineSemaphores = vulkan12Features.timelineSemaphore == VK_TRUE;
+	}
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties (device, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+		if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+			info.deviceLocalBytes = std::max (info.deviceLocalBytes, memoryProperties.memoryHeaps[i].size);
+		}
+	}
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties (device, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyList (queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties (device, &queueFamilyCount, queueFamilyList.data ());
+
+	for (const auto& queueFamily : queueFamilyList) {
+		if (queueFamily.queueCount == 0) {
+			continue;
+		}
+
+		bool graphics = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+		bool compute = queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT;
+		bool transfer = queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT;
+
+		info.dedicatedComputeQueue = info.dedicatedComputeQueue || (compute && !graphics);
+		info.dedicatedTransferQueue = info.dedicatedTransferQueue || (transfer && !compute && !graphics);
+	}
+
+	return info;
+}
+
+
+int64_t ScorePhysicalDevice (const PhysicalDeviceInfo& info)
+{
+	int64_t score = 0;
+
+	// a discrete GPU wins over anything an integrated one can make up for below
+	switch (info.properties.deviceType) {
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score += 10000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score += 4000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score += 2000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			score += 500;
+			break;
+		default:
+			break;
+	}
+
+	// 100 per GiB up to 32 GiB; integrated GPUs report shared system memory here, hence the cap
+	int64_t deviceLocalGiB = static_cast<int64_t> (info.deviceLocalBytes >> 30);
+	score += std::min<int64_t> (deviceLocalGiB, 32) * 100;
+
+	// separate queues let uploads and compute overlap graphics instead of queueing behind it
+	score += info.dedicatedComputeQueue ? 300 : 0;
+	score += info.dedicatedTransferQueue ? 300 : 0;
+	score += info.timelineSemaphores ? 200 : 0;
+
+	const VkPhysicalDeviceLimits& limits = info.properties.limits;
+	score += limits.maxImageDimension2D / 1024;
+	score += limits.maxComputeSharedMemorySize / 4096;
+	score += std::min<uint32_t> (limits.maxBoundDescriptorSets, 32);
+
+	return score;
+}
+
+
+static std::string FormatUuid (const std::array<uint8_t, VK_UUID_SIZE>& uuid)
+{
+	static const char digits[] = "0123456789abcdef";
+
+	std::string text;
+	for (size_t i = 0; i < uuid.size (); ++i) {
+		if (i == 4 || i == 6 || i == 8 || i == 10) {
+			text += '-';
+		}
+		text += digits[uuid[i] >> 4];
+		text += digits[uuid[i] & 0xF];
+	}
+
+	return text;
+}
+
+
+bool MatchesDeviceOverride (const PhysicalDeviceInfo& info, const std::string& deviceOverride)
+{
+	static const std::string IndexPrefix = "index:";
+	static const std::string UuidPrefix = "uuid:";
+	// uint32_t has at most 10 decimal digits, a UUID always has 32 hex ones
+	static constexpr size_t MaxIndexDigits = 10;
+
+	auto isDecimal = [] (const std::string& text) {
+		return !text.empty () && std::all_of (text.begin (), text.end (), [] (char c) { return std::isdigit (static_cast<unsigned char> (c)); });
+	};
+
+	std::string value = deviceOverride;
+	bool isIndex;
+	if (value.compare (0, IndexPrefix.size (), IndexPrefix) == 0) {
+		value.erase (0, IndexPrefix.size ());
+		isIndex = true;
+	} else if (value.compare (0, UuidPrefix.size (), UuidPrefix) == 0) {
+		value.erase (0, UuidPrefix.size ());
+		isIndex = false;
+	} else {
+		// a UUID can be all decimal digits too, so without a prefix only short numbers are indices
+		isIndex = isDecimal (value) && value.size () <= MaxIndexDigits;
+	}
+
+	if (isIndex) {
+		return isDecimal (value) && value.size () <= MaxIndexDigits && std::strtoull (value.c_str (), nullptr, 10) == info.index;
+	}
+
+	if (!info.hasUuid || value.empty ()) {
+		return false;
+	}
+
+	std::string expected;
+	for (char c : value) {
+		if (c != '-') {
+			expected += static_cast<char> (std::tolower (static_cast<unsigned char> (c)));
+		}
+	}
+
+	std::string actual = FormatUuid (info.uuid);
+	actual.erase (std::remove (actual.begin (), actual.end (), '-'), actual.end ());
+
+	return expected == actual;
+}
+
+
+std::string MakeDeviceOverride (const PhysicalDeviceInfo& info)
+{
+	return info.hasUuid ? FormatUuid (info.uuid) : std::to_string (info.index);
+}
+
+
+std::string DescribePhysicalDevice (const PhysicalDeviceInfo& info)
+{
+	static const char* deviceTypes[] = {"other", "integrated", "discrete", "virtual", "cpu"};
+
+	uint32_t deviceType = static_cast<uint32_t> (info.properties.deviceType);
+	uint32_t apiVersion = info.properties.apiVersion;
+
+	std::ostringstream description;
+	description << "[" << info.index << "] " << info.properties.deviceName
+				<< " (" << (deviceType < 5 ? deviceTypes[deviceType] : "unknown")
+				<< ", " << (info.deviceLocalBytes >> 20) << " MiB"
+				<< ", Vulkan " << VK_VERSION_MAJOR (apiVersion) << "." << VK_VERSION_MINOR (apiVersion) << "." << VK_VERSION_PATCH (apiVersion);
+	if (info.hasUuid) {
+		description << ", " << FormatUuid (info.uuid);
+	}
+	description << ")";
+
+	return description.str ();
+}
+
+
+std::vector<PhysicalDeviceInfo> QueryPhysicalDevices ()
+{
+	uint32_t loaderVersion = VK_API_VERSION_1_0;
+	vkEnumerateInstanceVersion (&loaderVersion);
+	uint32_t instanceApiVersion = loaderVersion >= VK_API_VERSION_1_2 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0;
+
+	VkApplicationInfo applicationInfo {};
+	applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	applicationInfo.pApplicationName = "Vulkan App";
+	applicationInfo.apiVersion = instanceApiVersion;
+
+	VkInstanceCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo = &applicationInfo;
+
+	VkInstance instance;
+	if (vkCreateInstance (&createInfo, nullptr, &instance) != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a vulkan instance...");
+	}
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices (instance, &deviceCount, nullptr);
+	std::vector<VkPhysicalDevice> deviceList (deviceCount);
+	vkEnumeratePhysicalDevices (instance, &deviceCount, deviceList.data ());
+
+	std::vector<PhysicalDeviceInfo> devices;
+	for (uint32_t i = 0; i < deviceCount; ++i) {
+		devices.push_back (GetPhysicalDeviceInfo (deviceList[i], i, instanceApiVersion));
+		devices.back ().device = VK_NULL_HANDLE;
+	}
+
+	vkDestroyInstance (instance, nullptr);
+
+	return devices;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_DEVICESELECTION_H
+#define VULKANPROJECT_I_DEVICESELECTION_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+struct PhysicalDeviceInfo {
+	VkPhysicalDevice device;
+	// position in vkEnumeratePhysicalDevices, what an index override refers to
+	uint32_t index;
+	VkPhysicalDeviceProperties properties;
+	bool hasUuid;
+	std::array<uint8_t, VK_UUID_SIZE> uuid;
+	// largest device local heap, the closest thing Vulkan has to "VRAM size"
+	VkDeviceSize deviceLocalBytes;
+	bool dedicatedComputeQueue;
+	bool dedicatedTransferQueue;
+	bool timelineSemaphores;
+};
+
+
+// instanceApiVersion decides which queries are available, UUIDs need Vulkan 1.1
+PhysicalDeviceInfo GetPhysicalDeviceInfo (VkPhysicalDevice device, uint32_t index, uint32_t instanceApiVersion);
+
+// higher is better; device type dominates, then memory, queues and limits break ties
+int64_t ScorePhysicalDevice (const PhysicalDeviceInfo& info);
+
+// an override is a decimal enumeration index or a device UUID in hex, dashes optional. Either may
+// be prefixed with "index:" or "uuid:"; without one, only a number of at most 10 digits is an index
+bool MatchesDeviceOverride (const PhysicalDeviceInfo& info, const std::string& deviceOverride);
+// the UUID when the device has one, since enumeration order is not promised to be stable
+std::string MakeDeviceOverride (const PhysicalDeviceInfo& info);
+
+std::string DescribePhysicalDevice (const PhysicalDeviceInfo& info);
+
+// every device on the system, from a short lived instance of its own; the device handles are
+// cleared since that instance is gone, index is what a device override should use
+std::vector<PhysicalDeviceInfo> QueryPhysicalDevices ();
+
+
+#endif //VULKANPROJECT_I_DEVICESELECTION_H
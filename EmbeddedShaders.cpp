@@ -0,0 +1,30 @@
+#include "EmbeddedShaders.h"
+
+#include <algorithm>
+#include <iterator>
+
+// generated by the build, defines EmbeddedShaderTable
+#include "EmbeddedShaderTable.h"
+
+
+const EmbeddedShader* FindEmbeddedShader (const std::string& fileName)
+{
+	auto found = std::find_if (std::begin (EmbeddedShaderTable), std::end (EmbeddedShaderTable), [&fileName] (const EmbeddedShader& shader) {
+		return fileName == shader.fileName;
+	});
+
+	return found != std::end (EmbeddedShaderTable) ? found : nullptr;
+}
+
+
+std::vector<const EmbeddedShader*> FindEmbeddedShaderVariants (const std::string& sourceFileName)
+{
+	std::vector<const EmbeddedShader*> variants;
+	for (const auto& shader : EmbeddedShaderTable) {
+		if (sourceFileName == shader.sourceFileName) {
+			variants.push_back (&shader);
+		}
+	}
+
+	return variants;
+}
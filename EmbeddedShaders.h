@@ -0,0 +1,32 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_EMBEDDEDSHADERS_H
+#define VULKANPROJECT_I_EMBEDDEDSHADERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// SPIR-V compiled from Shaders/ at build time, see embed_shader () in CMakeLists.txt
+struct EmbeddedShader {
+	// name the module would have as a file, e.g. "frag.spv"; hot reload matches on it
+	const char* fileName;
+	const uint32_t* code;
+	// in bytes, as VkShaderModuleCreateInfo wants it
+	size_t codeSize;
+	// GLSL file in Shaders/ it was compiled from, e.g. "shader.frag"
+	const char* sourceFileName;
+	// space separated preprocessor defines it was compiled with, e.g. "BINDLESS"
+	const char* defines;
+};
+
+
+// nullptr when no shader of that name was embedded
+const EmbeddedShader* FindEmbeddedShader (const std::string& fileName);
+// every module built from the GLSL file, one per set of defines
+std::vector<const EmbeddedShader*> FindEmbeddedShaderVariants (const std::string& sourceFileName);
+
+
+#endif //VULKANPROJECT_I_EMBEDDEDSHADERS_H
@@ -0,0 +1,54 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+
+void* FrameArena::Allocate (size_t size, size_t alignment)
+{
+	if (blocks.empty ()) {
+		AddBlock (std::max (InitialCapacity, size + alignment));
+	}
+
+	// only the newest block is bumped, the older ones are full
+	Block& block = blocks.back ();
+	uintptr_t base = reinterpret_cast<uintptr_t> (block.memory.get ());
+	size_t alignedOffset = ((base + offset + alignment - 1) & ~(uintptr_t (alignment) - 1)) - base;
+
+	if (alignedOffset + size > block.size) {
+		AddBlock (std::max (block.size * 2, size + alignment));
+		return Allocate (size, alignment);
+	}
+
+	offset = alignedOffset + size;
+	return block.memory.get () + alignedOffset;
+}
+
+
+void FrameArena::Reset ()
+{
+	if (blocks.size () > 1) {
+		size_t capacity = GetCapacity ();
+		blocks.clear ();
+		AddBlock (capacity);
+	}
+
+	offset = 0;
+}
+
+
+size_t FrameArena::GetCapacity () const
+{
+	size_t capacity = 0;
+	for (const auto& block : blocks) {
+		capacity += block.size;
+	}
+
+	return capacity;
+}
+
+
+void FrameArena::AddBlock (size_t size)
+{
+	blocks.push_back ({std::make_unique<uint8_t[]> (size), size});
+	offset = 0;
+}
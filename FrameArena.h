@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_FRAMEARENA_H
+#define VULKANPROJECT_I_FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+// bump allocator for CPU data that only lives until its frame has been submitted, one per frame
+// in flight and reset once that frame's fence has signaled. It grows while the first frames find
+// the high water mark and then never touches the heap again
+class FrameArena
+{
+public:
+	static constexpr size_t InitialCapacity = 64 * 1024;
+
+	// nothing is destructed on Reset, so only trivially destructible types
+	template <typename T>
+	T* Allocate (size_t count)
+	{
+		static_assert (std::is_trivially_destructible<T>::value, "FrameArena never runs destructors...");
+		return static_cast<T*> (Allocate (count * sizeof (T), alignof (T)));
+	}
+
+	void* Allocate (size_t size, size_t alignment);
+	// forgets every allocation; blocks added while growing are merged into one
+	void Reset ();
+
+	size_t GetCapacity () const;
+
+private:
+	struct Block {
+		std::unique_ptr<uint8_t[]> memory;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t offset = 0;
+
+	void AddBlock (size_t size);
+};
+
+
+#endif //VULKANPROJECT_I_FRAMEARENA_H
@@ -0,0 +1,157 @@
+#include "FrameCapture.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+
+bool FrameCaptureWriter::Start (CaptureOutput newOutput, const std::string& newTarget)
+{
+	Stop ();
+
+	output = newOutput;
+	target = newTarget;
+	writtenCount = 0;
+
+	if (output == CaptureOutput::Pipe) {
+		pipe = popen (target.c_str (), "w");
+		if (pipe == nullptr) {
+			std::cerr << "Capture> could not start " << target << std::endl;
+			return false;
+		}
+	}
+
+	stopping = false;
+	worker = std::thread (&FrameCaptureWriter::WorkerLoop, this);
+
+	return true;
+}
+
+
+void FrameCaptureWriter::Stop ()
+{
+	if (!worker.joinable ()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock (queueMutex);
+		stopping = true;
+	}
+	queueChanged.notify_one ();
+	worker.join ();
+
+	if (pipe != nullptr) {
+		pclose (pipe);
+		pipe = nullptr;
+	}
+}
+
+
+FrameCaptureWriter::~FrameCaptureWriter ()
+{
+	Stop ();
+}
+
+
+void FrameCaptureWriter::Submit (const CapturedFrame& frame)
+{
+	if (!worker.joinable ()) {
+		frame.inUse->store (false, std::memory_order_release);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock (queueMutex);
+		queue.push_back (frame);
+	}
+	queueChanged.notify_one ();
+}
+
+
+void FrameCaptureWriter::WaitUntilIdle ()
+{
+	std::unique_lock<std::mutex> lock (queueMutex);
+	queueDrained.wait (lock, [this] () { return (queue.empty () && !writing) || !worker.joinable (); });
+}
+
+
+void FrameCaptureWriter::WorkerLoop ()
+{
+	std::unique_lock<std::mutex> lock (queueMutex);
+
+	while (true) {
+		queueChanged.wait (lock, [this] () { return stopping || !queue.empty (); });
+		if (queue.empty ()) {
+			break;
+		}
+
+		CapturedFrame frame = queue.front ();
+		queue.pop_front ();
+		writing = true;
+
+		lock.unlock ();
+		WriteFrame (frame);
+		lock.lock ();
+
+		writing = false;
+		if (queue.empty ()) {
+			queueDrained.notify_all ();
+		}
+	}
+
+	queueDrained.notify_all ();
+}
+
+
+void FrameCaptureWriter::WriteFrame (const CapturedFrame& frame)
+{
+	// copy out of the readback ring first, so the slot goes back to the renderer before any I/O
+	size_t pixelCount = static_cast<size_t> (frame.width) * frame.height;
+	scratch.width = frame.width;
+	scratch.height = frame.height;
+	scratch.pixels.resize (pixelCount * 4);
+
+	if (frame.bgra) {
+		const uint8_t* source = frame.pixels;
+		uint8_t* destination = scratch.pixels.data ();
+		for (size_t i = 0; i < pixelCount; ++i, source += 4, destination += 4) {
+			destination[0] = source[2];
+			destination[1] = source[1];
+			destination[2] = source[0];
+			destination[3] = source[3];
+		}
+	} else {
+		std::memcpy (scratch.pixels.data (), frame.pixels, scratch.pixels.size ());
+	}
+
+	frame.inUse->store (false, std::memory_order_release);
+
+	try {
+		if (output == CaptureOutput::Pipe) {
+			if (std::fwrite (scratch.pixels.data (), 1, scratch.pixels.size (), pipe) != scratch.pixels.size ()) {
+				throw std::runtime_error ("Failed to write a frame to " + target + "...");
+			}
+		} else {
+			std::ostringstream fileName;
+			fileName << target << "/frame_" << std::setw (6) << std::setfill ('0') << frame.frameNumber
+					 << (output == CaptureOutput::Png ? ".png" : ".rgba");
+
+			if (output == CaptureOutput::Png) {
+				WritePng (fileName.str (), scratch);
+			} else {
+				WriteRawImage (fileName.str (), scratch);
+			}
+		}
+		++writtenCount;
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Capture> " << runtimeError.what () << std::endl;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_FRAMECAPTURE_H
+#define VULKANPROJECT_I_FRAMECAPTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ImageIO.h"
+
+
+enum class CaptureOutput {
+	Raw,	// <target>/frame_<n>.rgba
+	Png,	// <target>/frame_<n>.png
+	Pipe	// target is a shell command, RGBA frames are streamed to its stdin
+};
+
+
+struct CapturedFrame {
+	uint64_t frameNumber;
+	uint32_t width;
+	uint32_t height;
+	// swapchains are usually BGRA, every output is swizzled to RGBA
+	bool bgra;
+	// mapped readback memory, only valid until the writer clears inUse
+	const uint8_t* pixels;
+	std::atomic<bool>* inUse;
+};
+
+
+// drains captured frames on a worker thread; the render thread only queues them, so disk or
+// encoder speed never shows up in frame times (a slow writer costs dropped captures instead)
+class FrameCaptureWriter
+{
+public:
+	FrameCaptureWriter () = default;
+	FrameCaptureWriter (const FrameCaptureWriter&) = delete;
+	FrameCaptureWriter& operator= (const FrameCaptureWriter&) = delete;
+
+	// e.g. Pipe with "ffmpeg -f rawvideo -pix_fmt rgba -s 800x600 -i - capture.mp4"
+	bool Start (CaptureOutput newOutput, const std::string& newTarget);
+	// writes everything already queued, then stops
+	void Stop ();
+
+	void Submit (const CapturedFrame& frame);
+	// until every submitted frame has been released, for resizes and shutdown
+	void WaitUntilIdle ();
+
+	uint64_t GetWrittenCount () const { return writtenCount; }
+
+	~FrameCaptureWriter ();
+
+private:
+	CaptureOutput output = CaptureOutput::Raw;
+	std::string target;
+	FILE* pipe = nullptr;
+
+	std::thread worker;
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::condition_variable queueDrained;
+	std::deque<CapturedFrame> queue;
+	bool stopping = false;
+	bool writing = false;
+
+	std::atomic<uint64_t> writtenCount {0};
+	Image scratch;
+
+	void WorkerLoop ();
+	void WriteFrame (const CapturedFrame& frame);
+};
+
+
+#endif //VULKANPROJECT_I_FRAMECAPTURE_H
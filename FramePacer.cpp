@@ -0,0 +1,96 @@
+#include "FramePacer.h"
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <thread>
+
+
+FramePacer::FramePacer (double targetFrameRate)
+{
+	SetTargetFrameRate (targetFrameRate);
+
+	lastFrameStart = Clock::now ();
+	nextDeadline = lastFrameStart;
+	lastReport = lastFrameStart;
+}
+
+
+void FramePacer::SetTargetFrameRate (double targetFrameRate)
+{
+	if (targetFrameRate > 0.0) {
+		framePeriod = std::chrono::duration_cast<Clock::duration> (std::chrono::duration<double> (1.0 / targetFrameRate));
+	} else {
+		framePeriod = Clock::duration::zero ();
+	}
+}
+
+
+void FramePacer::WaitForNextFrame ()
+{
+	if (framePeriod > Clock::duration::zero ()) {
+		Clock::time_point now = Clock::now ();
+
+		if (nextDeadline - now > SpinThreshold) {
+			std::this_thread::sleep_for (nextDeadline - now - SpinThreshold);
+		}
+		while (Clock::now () < nextDeadline) {
+			std::this_thread::yield ();
+		}
+
+		// a frame that ran long moves the schedule instead of making the next ones rush to catch up
+		nextDeadline += framePeriod;
+		if (nextDeadline < Clock::now ()) {
+			nextDeadline = Clock::now () + framePeriod;
+		}
+	}
+
+	Clock::time_point frameStart = Clock::now ();
+	deltaTime = std::chrono::duration<double> (frameStart - lastFrameStart).count ();
+	lastFrameStart = frameStart;
+
+	frameTimes.push_back (deltaTime * 1000.0);
+
+	if (frameStart - lastReport >= ReportInterval) {
+		Report ();
+		lastReport = frameStart;
+	}
+}
+
+
+void FramePacer::RecordLatency (double latencyMilliseconds)
+{
+	latencies.push_back (latencyMilliseconds);
+}
+
+
+void FramePacer::Report ()
+{
+	auto summarize = [] (std::vector<double>& samples, double& average, double& percentile99) {
+		average = 0.0;
+		percentile99 = 0.0;
+		if (samples.empty ()) {
+			return;
+		}
+
+		for (double sample : samples) {
+			average += sample;
+		}
+		average /= static_cast<double> (samples.size ());
+
+		size_t index = std::min (samples.size () - 1, samples.size () * 99 / 100);
+		std::nth_element (samples.begin (), samples.begin () + index, samples.end ());
+		percentile99 = samples[index];
+	};
+
+	double averageFrameTime, frameTime99;
+	double averageLatency, latency99;
+	summarize (frameTimes, averageFrameTime, frameTime99);
+	summarize (latencies, averageLatency, latency99);
+
+	// runs on the render thread, which must not wait for the terminal
+	Log (LogStream::Out, "Frame> ", averageFrameTime, " ms avg, ", frameTime99, " ms p99 | latency ",
+		 averageLatency, " ms avg, ", latency99, " ms p99");
+
+	frameTimes.clear ();
+	latencies.clear ();
+}
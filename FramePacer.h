@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_FRAMEPACER_H
+#define VULKANPROJECT_I_FRAMEPACER_H
+
+#include <chrono>
+#include <vector>
+
+
+class FramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// the last stretch before a deadline is spun instead of slept, sleep overshoots by about this much
+	static constexpr std::chrono::microseconds SpinThreshold {1500};
+	static constexpr std::chrono::seconds ReportInterval {5};
+
+	explicit FramePacer (double targetFrameRate = 60.0);
+
+	// 0 disables the limiter, frames then run as fast as presentation allows
+	void SetTargetFrameRate (double targetFrameRate);
+
+	void WaitForNextFrame ();
+	void RecordLatency (double latencyMilliseconds);
+
+	double GetDeltaTime () const { return deltaTime; }
+
+private:
+	Clock::duration framePeriod {};
+	Clock::time_point nextDeadline;
+	Clock::time_point lastFrameStart;
+	Clock::time_point lastReport;
+	double deltaTime = 0.0;
+
+	std::vector<double> frameTimes;
+	std::vector<double> latencies;
+
+	void Report ();
+};
+
+
+#endif //VULKANPROJECT_I_FRAMEPACER_H
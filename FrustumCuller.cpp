@@ -0,0 +1,306 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUMCULLER_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FRUSTUMCULLER_NEON
+#endif
+
+
+uint32_t FrustumCuller::AddObject (const BoundingSphere& sphere, const BoundingBox& box)
+{
+	size_t objectIndex = objectCount++;
+
+	size_t paddedCount = (objectCount + BatchWidth - 1) / BatchWidth * BatchWidth;
+	if (paddedCount > sphereX.size ()) {
+		// padding lanes get a negative infinite radius and an inverted box, so they never pass
+		sphereX.resize (paddedCount, 0.0f);
+		sphereY.resize (paddedCount, 0.0f);
+		sphereZ.resize (paddedCount, 0.0f);
+		sphereRadius.resize (paddedCount, -FLT_MAX);
+		boxMinX.resize (paddedCount, FLT_MAX);
+		boxMinY.resize (paddedCount, FLT_MAX);
+		boxMinZ.resize (paddedCount, FLT_MAX);
+		boxMaxX.resize (paddedCount, -FLT_MAX);
+		boxMaxY.resize (paddedCount, -FLT_MAX);
+		boxMaxZ.resize (paddedCount, -FLT_MAX);
+	}
+
+	WriteObject (objectIndex, sphere, box);
+
+	return static_cast<uint32_t> (objectIndex);
+}
+
+
+void FrustumCuller::UpdateObject (uint32_t objectIndex, const BoundingSphere& sphere, const BoundingBox& box)
+{
+	if (objectIndex >= objectCount) {
+		throw std::out_of_range ("Culling object index out of range...");
+	}
+
+	WriteObject (objectIndex, sphere, box);
+}
+
+
+void FrustumCuller::Clear ()
+{
+	objectCount = 0;
+	for (auto* stream : {&sphereX, &sphereY, &sphereZ, &sphereRadius, &boxMinX, &boxMinY, &boxMinZ, &boxMaxX, &boxMaxY, &boxMaxZ}) {
+		stream->clear ();
+	}
+}
+
+
+void FrustumCuller::WriteObject (size_t objectIndex, const BoundingSphere& sphere, const BoundingBox& box)
+{
+	sphereX[objectIndex] = sphere.center.x;
+	sphereY[objectIndex] = sphere.center.y;
+	sphereZ[objectIndex] = sphere.center.z;
+	sphereRadius[objectIndex] = sphere.radius;
+	boxMinX[objectIndex] = box.min.x;
+	boxMinY[objectIndex] = box.min.y;
+	boxMinZ[objectIndex] = box.min.z;
+	boxMaxX[objectIndex] = box.max.x;
+	boxMaxY[objectIndex] = box.max.y;
+	boxMaxZ[objectIndex] = box.max.z;
+}
+
+
+void FrustumCuller::SetViewProjection (const glm::mat4& viewProjection)
+{
+	// glm is column major, so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	auto row = [&viewProjection] (int i) {
+		return glm::vec4 (viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	};
+
+	// Vulkan clip space: -w <= x, y <= w and 0 <= z <= w
+	glm::vec4 planes[6] = {
+		row (3) + row (0),	// left
+		row (3) - row (0),	// right
+		row (3) + row (1),	// top
+		row (3) - row (1),	// bottom
+		row (2),			// near
+		row (3) - row (2)	// far
+	};
+
+	for (int i = 0; i < 6; ++i) {
+		float length = glm::length (glm::vec3 (planes[i]));
+		if (length > 0.0f) {
+			planes[i] /= length;
+		}
+
+		planeX[i] = planes[i].x;
+		planeY[i] = planes[i].y;
+		planeZ[i] = planes[i].z;
+		planeW[i] = planes[i].w;
+	}
+}
+
+
+void FrustumCuller::Cull (std::vector<uint32_t>& visibleObjects, unsigned int threadCount)
+{
+	visibleObjects.clear ();
+
+	size_t maxUsefulThreads = (objectCount + MinObjectsPerThread - 1) / MinObjectsPerThread;
+	size_t chunkCount = std::max<size_t> (1, std::min<size_t> (threadCount, maxUsefulThreads));
+
+	if (chunkCount == 1) {
+		CullRange (0, objectCount, visibleObjects);
+		return;
+	}
+
+	// chunk boundaries stay on batch boundaries so no two threads share a SIMD batch
+	size_t batchCount = (objectCount + BatchWidth - 1) / BatchWidth;
+	size_t chunkSize = (batchCount + chunkCount - 1) / chunkCount * BatchWidth;
+
+	// the workers are all waiting here, nothing else touches threadResults
+	if (threadResults.size () < chunkCount) {
+		threadResults.resize (chunkCount);
+	}
+	while (workers.size () < chunkCount - 1) {
+		std::lock_guard<std::mutex> lock (workMutex);
+		workers.emplace_back (&FrustumCuller::WorkerLoop, this, workers.size () + 1, workGeneration);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock (workMutex);
+		workChunkCount = chunkCount;
+		workChunkSize = chunkSize;
+		pendingChunks = chunkCount - 1;
+		++workGeneration;
+	}
+	workStarted.notify_all ();
+
+	CullRange (0, std::min (chunkSize, objectCount), visibleObjects);
+
+	{
+		std::unique_lock<std::mutex> lock (workMutex);
+		workFinished.wait (lock, [this] () { return pendingChunks == 0; });
+	}
+
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		visibleObjects.insert (visibleObjects.end (), threadResults[chunk].begin (), threadResults[chunk].end ());
+	}
+}
+
+
+void FrustumCuller::WorkerLoop (size_t chunk, uint64_t seenGeneration)
+{
+	while (true) {
+		size_t begin;
+		size_t end;
+		{
+			std::unique_lock<std::mutex> lock (workMutex);
+			workStarted.wait (lock, [this, seenGeneration] () { return stopping || workGeneration != seenGeneration; });
+			if (stopping) {
+				return;
+			}
+
+			seenGeneration = workGeneration;
+			// fewer chunks than workers this time
+			if (chunk >= workChunkCount) {
+				continue;
+			}
+			begin = std::min (chunk * workChunkSize, objectCount);
+			end = std::min (begin + workChunkSize, objectCount);
+		}
+
+		threadResults[chunk].clear ();
+		CullRange (begin, end, threadResults[chunk]);
+
+		std::lock_guard<std::mutex> lock (workMutex);
+		if (--pendingChunks == 0) {
+			workFinished.notify_one ();
+		}
+	}
+}
+
+
+FrustumCuller::~FrustumCuller ()
+{
+	{
+		std::lock_guard<std::mutex> lock (workMutex);
+		stopping = true;
+	}
+	workStarted.notify_all ();
+
+	for (auto& worker : workers) {
+		worker.join ();
+	}
+}
+
+
+void FrustumCuller::CullRange (size_t begin, size_t end, std::vector<uint32_t>& visibleObjects) const
+{
+	// the box corner furthest along each plane normal is fixed per plane, so pick its streams up front
+	const float* cornerX[6];
+	const float* cornerY[6];
+	const float* cornerZ[6];
+	for (int p = 0; p < 6; ++p) {
+		cornerX[p] = planeX[p] >= 0.0f ? boxMaxX.data () : boxMinX.data ();
+		cornerY[p] = planeY[p] >= 0.0f ? boxMaxY.data () : boxMinY.data ();
+		cornerZ[p] = planeZ[p] >= 0.0f ? boxMaxZ.data () : boxMinZ.data ();
+	}
+
+	for (size_t i = begin; i < end; i += BatchWidth) {
+		uint32_t visibleMask = 0;
+
+#if defined(__AVX__)
+		__m256 x = _mm256_loadu_ps (&sphereX[i]);
+		__m256 y = _mm256_loadu_ps (&sphereY[i]);
+		__m256 z = _mm256_loadu_ps (&sphereZ[i]);
+		__m256 negativeRadius = _mm256_sub_ps (_mm256_setzero_ps (), _mm256_loadu_ps (&sphereRadius[i]));
+		__m256 visible = _mm256_castsi256_ps (_mm256_set1_epi32 (-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m256 a = _mm256_set1_ps (planeX[p]);
+			__m256 b = _mm256_set1_ps (planeY[p]);
+			__m256 c = _mm256_set1_ps (planeZ[p]);
+			__m256 d = _mm256_set1_ps (planeW[p]);
+
+			__m256 sphereDistance = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (a, x), _mm256_mul_ps (b, y)), _mm256_add_ps (_mm256_mul_ps (c, z), d));
+			__m256 boxDistance = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (a, _mm256_loadu_ps (cornerX[p] + i)),
+															   _mm256_mul_ps (b, _mm256_loadu_ps (cornerY[p] + i))),
+												_mm256_add_ps (_mm256_mul_ps (c, _mm256_loadu_ps (cornerZ[p] + i)), d));
+
+			visible = _mm256_and_ps (visible, _mm256_cmp_ps (sphereDistance, negativeRadius, _CMP_GE_OQ));
+			visible = _mm256_and_ps (visible, _mm256_cmp_ps (boxDistance, _mm256_setzero_ps (), _CMP_GE_OQ));
+		}
+
+		visibleMask = static_cast<uint32_t> (_mm256_movemask_ps (visible));
+#elif defined(FRUSTUMCULLER_SSE)
+		__m128 x = _mm_loadu_ps (&sphereX[i]);
+		__m128 y = _mm_loadu_ps (&sphereY[i]);
+		__m128 z = _mm_loadu_ps (&sphereZ[i]);
+		__m128 negativeRadius = _mm_sub_ps (_mm_setzero_ps (), _mm_loadu_ps (&sphereRadius[i]));
+		__m128 visible = _mm_castsi128_ps (_mm_set1_epi32 (-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m128 a = _mm_set1_ps (planeX[p]);
+			__m128 b = _mm_set1_ps (planeY[p]);
+			__m128 c = _mm_set1_ps (planeZ[p]);
+			__m128 d = _mm_set1_ps (planeW[p]);
+
+			__m128 sphereDistance = _mm_add_ps (_mm_add_ps (_mm_mul_ps (a, x), _mm_mul_ps (b, y)), _mm_add_ps (_mm_mul_ps (c, z), d));
+			__m128 boxDistance = _mm_add_ps (_mm_add_ps (_mm_mul_ps (a, _mm_loadu_ps (cornerX[p] + i)),
+														 _mm_mul_ps (b, _mm_loadu_ps (cornerY[p] + i))),
+											 _mm_add_ps (_mm_mul_ps (c, _mm_loadu_ps (cornerZ[p] + i)), d));
+
+			visible = _mm_and_ps (visible, _mm_cmpge_ps (sphereDistance, negativeRadius));
+			visible = _mm_and_ps (visible, _mm_cmpge_ps (boxDistance, _mm_setzero_ps ()));
+		}
+
+		visibleMask = static_cast<uint32_t> (_mm_movemask_ps (visible));
+#elif defined(FRUSTUMCULLER_NEON)
+		float32x4_t x = vld1q_f32 (&sphereX[i]);
+		float32x4_t y = vld1q_f32 (&sphereY[i]);
+		float32x4_t z = vld1q_f32 (&sphereZ[i]);
+		float32x4_t negativeRadius = vnegq_f32 (vld1q_f32 (&sphereRadius[i]));
+		uint32x4_t visible = vdupq_n_u32 (0xFFFFFFFFu);
+
+		for (int p = 0; p < 6; ++p) {
+			float32x4_t d = vdupq_n_f32 (planeW[p]);
+
+			float32x4_t sphereDistance = vmlaq_n_f32 (vmlaq_n_f32 (vmlaq_n_f32 (d, x, planeX[p]), y, planeY[p]), z, planeZ[p]);
+			float32x4_t boxDistance = vmlaq_n_f32 (vmlaq_n_f32 (vmlaq_n_f32 (d, vld1q_f32 (cornerX[p] + i), planeX[p]),
+																vld1q_f32 (cornerY[p] + i), planeY[p]),
+												   vld1q_f32 (cornerZ[p] + i), planeZ[p]);
+
+			visible = vandq_u32 (visible, vcgeq_f32 (sphereDistance, negativeRadius));
+			visible = vandq_u32 (visible, vcgeq_f32 (boxDistance, vdupq_n_f32 (0.0f)));
+		}
+
+		const uint32_t laneBits[4] = {1, 2, 4, 8};
+		visibleMask = vaddvq_u32 (vandq_u32 (visible, vld1q_u32 (laneBits)));
+#else
+		for (size_t lane = 0; lane < BatchWidth; ++lane) {
+			size_t object = i + lane;
+			bool visible = true;
+
+			for (int p = 0; p < 6 && visible; ++p) {
+				float sphereDistance = planeX[p] * sphereX[object] + planeY[p] * sphereY[object] + planeZ[p] * sphereZ[object] + planeW[p];
+				float boxDistance = planeX[p] * cornerX[p][object] + planeY[p] * cornerY[p][object] + planeZ[p] * cornerZ[p][object] + planeW[p];
+				visible = sphereDistance >= -sphereRadius[object] && boxDistance >= 0.0f;
+			}
+
+			visibleMask |= visible ? (1u << lane) : 0u;
+		}
+#endif
+
+		for (size_t lane = 0; lane < BatchWidth && visibleMask != 0; ++lane, visibleMask >>= 1) {
+			if ((visibleMask & 1u) && i + lane < end) {
+				visibleObjects.push_back (static_cast<uint32_t> (i + lane));
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_FRUSTUMCULLER_H
+#define VULKANPROJECT_I_FRUSTUMCULLER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+struct BoundingSphere {
+	glm::vec3 center;
+	float radius;
+};
+
+
+struct BoundingBox {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+
+class FrustumCuller
+{
+public:
+	// objects tested per iteration of the SIMD loop
+#if defined(__AVX__)
+	static constexpr size_t BatchWidth = 8;
+#else
+	static constexpr size_t BatchWidth = 4;
+#endif
+	// below this many objects per thread the extra threads cost more than they save
+	static constexpr size_t MinObjectsPerThread = 16384;
+
+	FrustumCuller () = default;
+	FrustumCuller (const FrustumCuller&) = delete;
+	FrustumCuller& operator= (const FrustumCuller&) = delete;
+	~FrustumCuller ();
+
+	uint32_t AddObject (const BoundingSphere& sphere, const BoundingBox& box);
+	void UpdateObject (uint32_t objectIndex, const BoundingSphere& sphere, const BoundingBox& box);
+	void Clear ();
+	size_t GetObjectCount () const { return objectCount; }
+
+	void SetViewProjection (const glm::mat4& viewProjection);
+	void Cull (std::vector<uint32_t>& visibleObjects, unsigned int threadCount = 1);
+
+private:
+	// plane i: planeX[i] * x + planeY[i] * y + planeZ[i] * z + planeW[i] >= 0 is inside
+	float planeX[6] {};
+	float planeY[6] {};
+	float planeZ[6] {};
+	float planeW[6] {};
+
+	// bounding volumes in SoA layout, padded to a multiple of BatchWidth
+	size_t objectCount = 0;
+	std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+	std::vector<float> boxMinX, boxMinY, boxMinZ;
+	std::vector<float> boxMaxX, boxMaxY, boxMaxZ;
+
+	std::vector<std::vector<uint32_t>> threadResults;
+
+	// helper threads, started by the first Cull that needs them and kept, so culling never
+	// creates threads per frame. Worker i culls chunk i + 1, the calling thread chunk 0
+	std::vector<std::thread> workers;
+	std::mutex workMutex;
+	std::condition_variable workStarted;
+	std::condition_variable workFinished;
+	uint64_t workGeneration = 0;
+	size_t workChunkCount = 0;
+	size_t workChunkSize = 0;
+	size_t pendingChunks = 0;
+	bool stopping = false;
+
+	void WorkerLoop (size_t chunk, uint64_t seenGeneration);
+	void WriteObject (size_t objectIndex, const BoundingSphere& sphere, const BoundingBox& box);
+	void CullRange (size_t begin, size_t end, std::vector<uint32_t>& visibleObjects) const;
+};
+
+
+#endif //VULKANPROJECT_I_FRUSTUMCULLER_H
@@ -0,0 +1,104 @@
+#include "HostAllocation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+static std::atomic<uint64_t> hostAllocationCount {0};
+static std::atomic<uint64_t> hostBytesInUse {0};
+
+// sits right before every pointer handed out, the driver gives back neither size nor offset
+struct AllocationHeader {
+	void* base;
+	size_t size;
+};
+
+
+static void* VKAPI_PTR Allocate (void*, size_t size, size_t alignment, VkSystemAllocationScope)
+{
+	alignment = std::max (alignment, alignof (AllocationHeader));
+
+	uint8_t* base = static_cast<uint8_t*> (std::malloc (size + alignment + sizeof (AllocationHeader)));
+	if (base == nullptr) {
+		return nullptr;
+	}
+
+	uintptr_t aligned = (reinterpret_cast<uintptr_t> (base) + sizeof (AllocationHeader) + alignment - 1) & ~(uintptr_t (alignment) - 1);
+	AllocationHeader* header = reinterpret_cast<AllocationHeader*> (aligned) - 1;
+	header->base = base;
+	header->size = size;
+
+	hostAllocationCount.fetch_add (1, std::memory_order_relaxed);
+	hostBytesInUse.fetch_add (size, std::memory_order_relaxed);
+
+	return reinterpret_cast<void*> (aligned);
+}
+
+
+static void VKAPI_PTR Free (void*, void* memory)
+{
+	if (memory == nullptr) {
+		return;
+	}
+
+	AllocationHeader* header = static_cast<AllocationHeader*> (memory) - 1;
+	hostBytesInUse.fetch_sub (header->size, std::memory_order_relaxed);
+	std::free (header->base);
+}
+
+
+static void* VKAPI_PTR Reallocate (void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (original == nullptr) {
+		return Allocate (userData, size, alignment, scope);
+	}
+	if (size == 0) {
+		Free (userData, original);
+		return nullptr;
+	}
+
+	// a fresh block, the new alignment may not match the old offset
+	void* memory = Allocate (userData, size, alignment, scope);
+	if (memory == nullptr) {
+		return nullptr;
+	}
+
+	std::memcpy (memory, original, std::min (size, (static_cast<AllocationHeader*> (original) - 1)->size));
+	Free (userData, original);
+
+	return memory;
+}
+
+
+const VkAllocationCallbacks* GetHostAllocationCallbacks ()
+{
+	static const VkAllocationCallbacks* callbacks = [] () -> const VkAllocationCallbacks* {
+		const char* setting = std::getenv ("VULKAN_HOST_ALLOCATOR");
+		if (setting != nullptr && std::string (setting) == "0") {
+			return nullptr;
+		}
+
+		static VkAllocationCallbacks allocationCallbacks {};
+		allocationCallbacks.pfnAllocation = Allocate;
+		allocationCallbacks.pfnReallocation = Reallocate;
+		allocationCallbacks.pfnFree = Free;
+		return &allocationCallbacks;
+	} ();
+
+	return callbacks;
+}
+
+
+uint64_t GetHostAllocationCount ()
+{
+	return hostAllocationCount.load (std::memory_order_relaxed);
+}
+
+
+uint64_t GetHostBytesInUse ()
+{
+	return hostBytesInUse.load (std::memory_order_relaxed);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_HOSTALLOCATION_H
+#define VULKANPROJECT_I_HOSTALLOCATION_H
+
+#include <cstdint>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+// VkAllocationCallbacks forwarding to malloc, counting every host allocation the driver makes
+// through them so tools can tell driver allocations in the frame loop apart from their own.
+// The same callbacks serve the whole process, any owner can destroy any object with them;
+// VULKAN_HOST_ALLOCATOR=0 returns nullptr and leaves host memory to the driver
+const VkAllocationCallbacks* GetHostAllocationCallbacks ();
+
+// allocations and reallocations made through the callbacks since startup
+uint64_t GetHostAllocationCount ();
+uint64_t GetHostBytesInUse ();
+
+
+#endif //VULKANPROJECT_I_HOSTALLOCATION_H
@@ -0,0 +1,147 @@
+#include "ImageDiff.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGEDIFF_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IMAGEDIFF_NEON
+#endif
+
+
+// below this many pixels per thread the extra threads cost more than they save
+static constexpr size_t MinPixelsPerThread = 1 << 18;
+
+
+static ImageDiffResult DiffRange (const uint8_t* expected, const uint8_t* actual, size_t pixelCount, uint8_t tolerance)
+{
+	ImageDiffResult diffResult;
+	size_t pixel = 0;
+
+#if defined(__AVX2__)
+	const __m256i toleranceVector = _mm256_set1_epi8 (static_cast<char> (tolerance));
+	__m256i maxDifference = _mm256_setzero_si256 ();
+
+	for (; pixel + 8 <= pixelCount; pixel += 8) {
+		__m256i a = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (expected + pixel * 4));
+		__m256i b = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (actual + pixel * 4));
+		__m256i difference = _mm256_or_si256 (_mm256_subs_epu8 (a, b), _mm256_subs_epu8 (b, a));
+		maxDifference = _mm256_max_epu8 (maxDifference, difference);
+
+		// a pixel is within tolerance when all four of its bytes saturate to zero
+		__m256i withinTolerance = _mm256_cmpeq_epi32 (_mm256_subs_epu8 (difference, toleranceVector), _mm256_setzero_si256 ());
+		int withinMask = _mm256_movemask_ps (_mm256_castsi256_ps (withinTolerance));
+		diffResult.mismatchedPixels += 8 - __builtin_popcount (static_cast<unsigned int> (withinMask));
+	}
+
+	alignas (32) uint8_t lanes[32];
+	_mm256_store_si256 (reinterpret_cast<__m256i*> (lanes), maxDifference);
+	diffResult.maxChannelDifference = *std::max_element (lanes, lanes + 32);
+#elif defined(IMAGEDIFF_SSE)
+	const __m128i toleranceVector = _mm_set1_epi8 (static_cast<char> (tolerance));
+	__m128i maxDifference = _mm_setzero_si128 ();
+
+	for (; pixel + 4 <= pixelCount; pixel += 4) {
+		__m128i a = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (expected + pixel * 4));
+		__m128i b = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (actual + pixel * 4));
+		__m128i difference = _mm_or_si128 (_mm_subs_epu8 (a, b), _mm_subs_epu8 (b, a));
+		maxDifference = _mm_max_epu8 (maxDifference, difference);
+
+		// a pixel is within tolerance when all four of its bytes saturate to zero
+		__m128i withinTolerance = _mm_cmpeq_epi32 (_mm_subs_epu8 (difference, toleranceVector), _mm_setzero_si128 ());
+		int withinMask = _mm_movemask_ps (_mm_castsi128_ps (withinTolerance));
+		diffResult.mismatchedPixels += 4 - ((withinMask & 1) + ((withinMask >> 1) & 1) + ((withinMask >> 2) & 1) + ((withinMask >> 3) & 1));
+	}
+
+	alignas (16) uint8_t lanes[16];
+	_mm_store_si128 (reinterpret_cast<__m128i*> (lanes), maxDifference);
+	diffResult.maxChannelDifference = *std::max_element (lanes, lanes + 16);
+#elif defined(IMAGEDIFF_NEON)
+	const uint8x16_t toleranceVector = vdupq_n_u8 (tolerance);
+	uint8x16_t maxDifference = vdupq_n_u8 (0);
+
+	for (; pixel + 4 <= pixelCount; pixel += 4) {
+		uint8x16_t difference = vabdq_u8 (vld1q_u8 (expected + pixel * 4), vld1q_u8 (actual + pixel * 4));
+		maxDifference = vmaxq_u8 (maxDifference, difference);
+
+		uint32x4_t overTolerance = vtstq_u32 (vreinterpretq_u32_u8 (vqsubq_u8 (difference, toleranceVector)), vdupq_n_u32 (0xFFFFFFFFu));
+		diffResult.mismatchedPixels += vaddvq_u32 (vshrq_n_u32 (overTolerance, 31));
+	}
+
+	diffResult.maxChannelDifference = vmaxvq_u8 (maxDifference);
+#endif
+
+	for (; pixel < pixelCount; ++pixel) {
+		bool mismatched = false;
+		for (size_t channel = 0; channel < 4; ++channel) {
+			uint8_t difference = static_cast<uint8_t> (std::abs (expected[pixel * 4 + channel] - actual[pixel * 4 + channel]));
+			diffResult.maxChannelDifference = std::max (diffResult.maxChannelDifference, difference);
+			mismatched = mismatched || difference > tolerance;
+		}
+		diffResult.mismatchedPixels += mismatched ? 1 : 0;
+	}
+
+	return diffResult;
+}
+
+
+ImageDiffResult DiffImages (const uint8_t* expected, const uint8_t* actual, size_t pixelCount, uint8_t tolerance, unsigned int threadCount)
+{
+	size_t maxUsefulThreads = (pixelCount + MinPixelsPerThread - 1) / MinPixelsPerThread;
+	size_t chunkCount = std::max<size_t> (1, std::min<size_t> (threadCount, maxUsefulThreads));
+
+	if (chunkCount == 1) {
+		return DiffRange (expected, actual, pixelCount, tolerance);
+	}
+
+	size_t chunkSize = (pixelCount + chunkCount - 1) / chunkCount;
+	std::vector<ImageDiffResult> chunkResults (chunkCount);
+	std::vector<std::thread> workers;
+	workers.reserve (chunkCount - 1);
+
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		size_t begin = std::min (chunk * chunkSize, pixelCount);
+		size_t count = std::min (chunkSize, pixelCount - begin);
+		workers.emplace_back ([&chunkResults, expected, actual, begin, count, tolerance, chunk] () {
+			chunkResults[chunk] = DiffRange (expected + begin * 4, actual + begin * 4, count, tolerance);
+		});
+	}
+
+	chunkResults[0] = DiffRange (expected, actual, std::min (chunkSize, pixelCount), tolerance);
+
+	ImageDiffResult diffResult = chunkResults[0];
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		workers[chunk - 1].join ();
+		diffResult.mismatchedPixels += chunkResults[chunk].mismatchedPixels;
+		diffResult.maxChannelDifference = std::max (diffResult.maxChannelDifference, chunkResults[chunk].maxChannelDifference);
+	}
+
+	return diffResult;
+}
+
+
+void BuildDiffHeatmap (const uint8_t* expected, const uint8_t* actual, size_t pixelCount, uint8_t tolerance, std::vector<uint8_t>& heatmap)
+{
+	heatmap.assign (pixelCount * 4, 0);
+
+	for (size_t pixel = 0; pixel < pixelCount; ++pixel) {
+		int difference = 0;
+		for (size_t channel = 0; channel < 4; ++channel) {
+			difference = std::max (difference, std::abs (expected[pixel * 4 + channel] - actual[pixel * 4 + channel]));
+		}
+
+		// small differences still show up bright enough to spot, full red at the largest
+		uint8_t* heat = &heatmap[pixel * 4];
+		if (difference > tolerance) {
+			heat[0] = static_cast<uint8_t> (std::min (255, 64 + difference * 3));
+			heat[1] = static_cast<uint8_t> (std::max (0, 192 - difference * 3));
+		}
+		heat[3] = 255;
+	}
+}
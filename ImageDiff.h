@@ -0,0 +1,24 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_IMAGEDIFF_H
+#define VULKANPROJECT_I_IMAGEDIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+struct ImageDiffResult {
+	uint64_t mismatchedPixels = 0;
+	uint8_t maxChannelDifference = 0;
+};
+
+
+// compares two tightly packed RGBA8 images; a pixel mismatches when any channel differs by more than tolerance
+ImageDiffResult DiffImages (const uint8_t* expected, const uint8_t* actual, size_t pixelCount, uint8_t tolerance, unsigned int threadCount = 1);
+
+// per pixel heatmap of the largest channel difference, black where within tolerance
+void BuildDiffHeatmap (const uint8_t* expected, const uint8_t* actual, size_t pixelCount, uint8_t tolerance, std::vector<uint8_t>& heatmap);
+
+
+#endif //VULKANPROJECT_I_IMAGEDIFF_H
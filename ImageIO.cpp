@@ -0,0 +1,174 @@
+#include "ImageIO.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+static const char RawImageMagic[8] = {'V', 'K', 'R', 'G', 'B', 'A', '0', '1'};
+
+
+static void AppendUint32 (std::vector<uint8_t>& bytes, uint32_t value, bool bigEndian)
+{
+	for (int i = 0; i < 4; ++i) {
+		int shift = bigEndian ? (24 - i * 8) : (i * 8);
+		bytes.push_back (static_cast<uint8_t> ((value >> shift) & 0xFF));
+	}
+}
+
+
+bool ReadRawImage (const std::string& fileName, Image& image)
+{
+	std::ifstream file (fileName, std::ios::binary | std::ios::ate);
+	if (!file.is_open ()) {
+		return false;
+	}
+	auto fileSize = static_cast<uint64_t> (file.tellg ());
+	file.seekg (0);
+
+	char magic[8];
+	uint8_t header[8];
+	file.read (magic, sizeof (magic));
+	file.read (reinterpret_cast<char*> (header), sizeof (header));
+	if (!file || std::memcmp (magic, RawImageMagic, sizeof (magic)) != 0) {
+		throw std::runtime_error ("Not a raw RGBA image: " + fileName + "...");
+	}
+
+	image.width = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t> (header[3]) << 24);
+	image.height = header[4] | (header[5] << 8) | (header[6] << 16) | (static_cast<uint32_t> (header[7]) << 24);
+
+	// checked before allocating, a damaged header must not ask for gigabytes
+	uint64_t pixelBytes = static_cast<uint64_t> (image.width) * image.height * 4;
+	if (pixelBytes != fileSize - sizeof (magic) - sizeof (header)) {
+		throw std::runtime_error ("Raw RGBA image size does not match its header: " + fileName + "...");
+	}
+	image.pixels.resize (static_cast<size_t> (pixelBytes));
+
+	file.read (reinterpret_cast<char*> (image.pixels.data ()), static_cast<std::streamsize> (image.pixels.size ()));
+	if (!file) {
+		throw std::runtime_error ("Truncated raw RGBA image: " + fileName + "...");
+	}
+
+	return true;
+}
+
+
+void WriteRawImage (const std::string& fileName, const Image& image)
+{
+	std::vector<uint8_t> header;
+	AppendUint32 (header, image.width, false);
+	AppendUint32 (header, image.height, false);
+
+	std::ofstream file (fileName, std::ios::binary);
+	if (!file.is_open ()) {
+		throw std::runtime_error ("Failed to open a file...");
+	}
+
+	file.write (RawImageMagic, sizeof (RawImageMagic));
+	file.write (reinterpret_cast<const char*> (header.data ()), static_cast<std::streamsize> (header.size ()));
+	file.write (reinterpret_cast<const char*> (image.pixels.data ()), static_cast<std::streamsize> (image.pixels.size ()));
+}
+
+
+static uint32_t Crc32 (const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const std::array<uint32_t, 256> table = [] () {
+		std::array<uint32_t, 256> crcTable {};
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; ++bit) {
+				value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			}
+			crcTable[i] = value;
+		}
+		return crcTable;
+	} ();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+static void AppendChunk (std::vector<uint8_t>& png, const char type[4], const std::vector<uint8_t>& data)
+{
+	AppendUint32 (png, static_cast<uint32_t> (data.size ()), true);
+
+	size_t typeOffset = png.size ();
+	png.insert (png.end (), type, type + 4);
+	png.insert (png.end (), data.begin (), data.end ());
+
+	AppendUint32 (png, Crc32 (&png[typeOffset], data.size () + 4), true);
+}
+
+
+void EncodePng (const Image& image, std::vector<uint8_t>& png)
+{
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	png.assign (signature, signature + 8);
+
+	std::vector<uint8_t> header;
+	AppendUint32 (header, image.width, true);
+	AppendUint32 (header, image.height, true);
+	header.push_back (8);	// bit depth
+	header.push_back (6);	// RGBA
+	header.push_back (0);	// deflate
+	header.push_back (0);	// adaptive filtering
+	header.push_back (0);	// no interlace
+	AppendChunk (png, "IHDR", header);
+
+	// every scanline gets filter type 0 in front of it
+	size_t rowSize = static_cast<size_t> (image.width) * 4;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve ((rowSize + 1) * image.height);
+	for (uint32_t y = 0; y < image.height; ++y) {
+		scanlines.push_back (0);
+		scanlines.insert (scanlines.end (), image.pixels.begin () + y * rowSize, image.pixels.begin () + (y + 1) * rowSize);
+	}
+
+	// zlib stream of stored deflate blocks
+	std::vector<uint8_t> compressed = {0x78, 0x01};
+	size_t offset = 0;
+	do {
+		size_t blockSize = std::min<size_t> (65535, scanlines.size () - offset);
+		bool lastBlock = offset + blockSize == scanlines.size ();
+
+		compressed.push_back (lastBlock ? 1 : 0);
+		compressed.push_back (static_cast<uint8_t> (blockSize & 0xFF));
+		compressed.push_back (static_cast<uint8_t> (blockSize >> 8));
+		compressed.push_back (static_cast<uint8_t> (~blockSize & 0xFF));
+		compressed.push_back (static_cast<uint8_t> ((~blockSize >> 8) & 0xFF));
+		compressed.insert (compressed.end (), scanlines.begin () + offset, scanlines.begin () + offset + blockSize);
+
+		offset += blockSize;
+	} while (offset < scanlines.size ());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (uint8_t byte : scanlines) {
+		adlerA = (adlerA + byte) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendUint32 (compressed, (adlerB << 16) | adlerA, true);
+
+	AppendChunk (png, "IDAT", compressed);
+	AppendChunk (png, "IEND", {});
+}
+
+
+void WritePng (const std::string& fileName, const Image& image)
+{
+	std::vector<uint8_t> png;
+	EncodePng (image, png);
+
+	std::ofstream file (fileName, std::ios::binary);
+	if (!file.is_open ()) {
+		throw std::runtime_error ("Failed to open a file...");
+	}
+
+	file.write (reinterpret_cast<const char*> (png.data ()), static_cast<std::streamsize> (png.size ()));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_IMAGEIO_H
+#define VULKANPROJECT_I_IMAGEIO_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// tightly packed RGBA8, rows top to bottom
+struct Image {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+
+// raw format: "VKRGBA01", little endian uint32 width and height, then the pixels
+bool ReadRawImage (const std::string& fileName, Image& image);
+void WriteRawImage (const std::string& fileName, const Image& image);
+
+// uncompressed (stored deflate) PNG, larger than a real encoder's output but dependency free
+void WritePng (const std::string& fileName, const Image& image);
+void EncodePng (const Image& image, std::vector<uint8_t>& png);
+
+
+#endif //VULKANPROJECT_I_IMAGEIO_H
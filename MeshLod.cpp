@@ -0,0 +1,231 @@
+#include "MeshLod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+
+uint32_t MeshLodLibrary::AddMesh (const std::vector<Vertex>& meshVertices, const std::vector<uint32_t>& meshIndices, uint32_t levelCount)
+{
+	ValidateLevel (meshVertices, meshIndices);
+
+	MeshLodChain chain {};
+	chain.bounds = ComputeBounds (meshVertices);
+	chain.levels.push_back (AppendLevel (meshVertices, meshIndices, 0.0f));
+
+	// each level halves the clustering grid resolution of the one before
+	uint32_t gridResolution = 64;
+	std::vector<Vertex> levelVertices;
+	std::vector<uint32_t> levelIndices;
+	size_t previousIndexCount = meshIndices.size ();
+
+	levelCount = std::min (levelCount, MaxLevels);
+	while (chain.levels.size () < levelCount && gridResolution >= 2) {
+		float cellSize = 2.0f * chain.bounds.radius / static_cast<float> (gridResolution);
+		SimplifyMesh (meshVertices, meshIndices, cellSize, levelVertices, levelIndices);
+
+		// stop once a level no longer pays for its memory
+		if (levelIndices.empty () || levelIndices.size () > previousIndexCount * 9 / 10) {
+			break;
+		}
+
+		chain.levels.push_back (AppendLevel (levelVertices, levelIndices, cellSize * std::sqrt (3.0f)));
+		previousIndexCount = levelIndices.size ();
+		gridResolution /= 2;
+	}
+
+	meshes.push_back (chain);
+
+	return static_cast<uint32_t> (meshes.size () - 1);
+}
+
+
+uint32_t MeshLodLibrary::AddMeshChain (const std::vector<std::vector<Vertex>>& levelVertices,
+									   const std::vector<std::vector<uint32_t>>& levelIndices,
+									   const std::vector<float>& levelErrors)
+{
+	if (levelVertices.empty () || levelVertices.size () > MaxLevels ||
+		levelVertices.size () != levelIndices.size () || levelVertices.size () != levelErrors.size ())
+	{
+		throw std::runtime_error ("Mesh LOD chain levels do not match...");
+	}
+	for (size_t level = 0; level < levelVertices.size (); ++level) {
+		ValidateLevel (levelVertices[level], levelIndices[level]);
+	}
+
+	MeshLodChain chain {};
+	chain.bounds = ComputeBounds (levelVertices[0]);
+	for (size_t level = 0; level < levelVertices.size (); ++level) {
+		chain.levels.push_back (AppendLevel (levelVertices[level], levelIndices[level], levelErrors[level]));
+	}
+
+	meshes.push_back (chain);
+
+	return static_cast<uint32_t> (meshes.size () - 1);
+}
+
+
+void MeshLodLibrary::ValidateLevel (const std::vector<Vertex>& levelVertices, const std::vector<uint32_t>& levelIndices)
+{
+	if (levelVertices.empty () || levelIndices.size () % 3 != 0) {
+		throw std::runtime_error ("Mesh must have vertices and a triangle list...");
+	}
+
+	// clustering and drawing both index straight into the level's vertices
+	auto largest = std::max_element (levelIndices.begin (), levelIndices.end ());
+	if (largest != levelIndices.end () && *largest >= levelVertices.size ()) {
+		throw std::runtime_error ("Mesh index out of range of its vertices...");
+	}
+}
+
+
+MeshLevel MeshLodLibrary::AppendLevel (const std::vector<Vertex>& levelVertices, const std::vector<uint32_t>& levelIndices, float error)
+{
+	MeshLevel level {};
+	level.firstIndex = static_cast<uint32_t> (indices.size ());
+	level.indexCount = static_cast<uint32_t> (levelIndices.size ());
+	level.vertexOffset = static_cast<int32_t> (vertices.size ());
+	level.error = error;
+
+	vertices.insert (vertices.end (), levelVertices.begin (), levelVertices.end ());
+	indices.insert (indices.end (), levelIndices.begin (), levelIndices.end ());
+
+	return level;
+}
+
+
+BoundingSphere MeshLodLibrary::ComputeBounds (const std::vector<Vertex>& meshVertices)
+{
+	glm::vec3 min = meshVertices[0].position;
+	glm::vec3 max = meshVertices[0].position;
+	for (const auto& vertex : meshVertices) {
+		min = glm::min (min, vertex.position);
+		max = glm::max (max, vertex.position);
+	}
+
+	BoundingSphere bounds {};
+	bounds.center = (min + max) * 0.5f;
+	bounds.radius = 0.0f;
+	for (const auto& vertex : meshVertices) {
+		bounds.radius = std::max (bounds.radius, glm::distance (bounds.center, vertex.position));
+	}
+
+	return bounds;
+}
+
+
+void MeshLodLibrary::SimplifyMesh (const std::vector<Vertex>& sourceVertices, const std::vector<uint32_t>& sourceIndices, float cellSize,
+								   std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// vertex clustering: every vertex in a grid cell collapses onto the cell average
+	outVertices.clear ();
+	outIndices.clear ();
+
+	std::unordered_map<uint64_t, uint32_t> cellToVertex;
+	std::vector<uint32_t> remap (sourceVertices.size ());
+	std::vector<uint32_t> clusterSizes;
+
+	for (size_t i = 0; i < sourceVertices.size (); ++i) {
+		const glm::vec3& position = sourceVertices[i].position;
+		auto cellX = static_cast<uint64_t> (static_cast<int64_t> (std::floor (position.x / cellSize)) & 0x1FFFFF);
+		auto cellY = static_cast<uint64_t> (static_cast<int64_t> (std::floor (position.y / cellSize)) & 0x1FFFFF);
+		auto cellZ = static_cast<uint64_t> (static_cast<int64_t> (std::floor (position.z / cellSize)) & 0x1FFFFF);
+		uint64_t cell = (cellX << 42) | (cellY << 21) | cellZ;
+
+		auto found = cellToVertex.find (cell);
+		if (found == cellToVertex.end ()) {
+			uint32_t clusterIndex = static_cast<uint32_t> (outVertices.size ());
+			cellToVertex.emplace (cell, clusterIndex);
+			outVertices.push_back ({glm::vec3 (0.0f), glm::vec3 (0.0f)});
+			clusterSizes.push_back (0);
+			remap[i] = clusterIndex;
+		} else {
+			remap[i] = found->second;
+		}
+
+		Vertex& cluster = outVertices[remap[i]];
+		cluster.position = cluster.position + sourceVertices[i].position;
+		cluster.color = cluster.color + sourceVertices[i].color;
+		++clusterSizes[remap[i]];
+	}
+
+	for (size_t i = 0; i < outVertices.size (); ++i) {
+		float weight = 1.0f / static_cast<float> (clusterSizes[i]);
+		outVertices[i].position = outVertices[i].position * weight;
+		outVertices[i].color = outVertices[i].color * weight;
+	}
+
+	for (size_t i = 0; i + 2 < sourceIndices.size (); i += 3) {
+		uint32_t a = remap[sourceIndices[i]];
+		uint32_t b = remap[sourceIndices[i + 1]];
+		uint32_t c = remap[sourceIndices[i + 2]];
+
+		// triangles that collapsed into a line or a point disappear
+		if (a != b && b != c && a != c) {
+			outIndices.push_back (a);
+			outIndices.push_back (b);
+			outIndices.push_back (c);
+		}
+	}
+}
+
+
+void LodSelector::SetProjection (float verticalFov, float viewportHeight)
+{
+	projectionScale = viewportHeight / (2.0f * std::tan (verticalFov * 0.5f));
+}
+
+
+void LodSelector::SetErrorThreshold (float pixels, float newHysteresis)
+{
+	errorThreshold = pixels;
+	hysteresis = newHysteresis;
+}
+
+
+void LodSelector::Select (const MeshLodLibrary& library,
+						  const std::vector<LodInstance>& instances,
+						  const std::vector<uint32_t>& visibleInstances,
+						  const glm::vec3& cameraPosition)
+{
+	currentLevels.resize (instances.size (), 0);
+
+	for (uint32_t instanceIndex : visibleInstances) {
+		const LodInstance& instance = instances[instanceIndex];
+		const MeshLodChain& mesh = library.GetMesh (instance.meshIndex);
+
+		glm::vec3 center = instance.position + mesh.bounds.center * instance.scale;
+		float distance = std::max (glm::distance (cameraPosition, center) - mesh.bounds.radius * instance.scale, 1e-4f);
+		// pixels per object space unit at this distance
+		float pixelsPerUnit = projectionScale * instance.scale / distance;
+
+		uint32_t coarsest = static_cast<uint32_t> (mesh.levels.size () - 1);
+		uint32_t current = std::min<uint32_t> (currentLevels[instanceIndex], coarsest);
+
+		// an object smaller than a pixel on screen gets the coarsest level outright
+		if (mesh.bounds.radius * pixelsPerUnit < 0.5f) {
+			currentLevels[instanceIndex] = static_cast<uint8_t> (coarsest);
+			continue;
+		}
+
+		uint32_t candidate = 0;
+		while (candidate < coarsest && mesh.levels[candidate + 1].error * pixelsPerUnit <= errorThreshold) {
+			++candidate;
+		}
+
+		// only switch once the projected error is clearly past the threshold, so objects
+		// sitting on a boundary do not flip between levels every frame
+		if (candidate > current) {
+			while (candidate > current && mesh.levels[candidate].error * pixelsPerUnit > errorThreshold * (1.0f - hysteresis)) {
+				--candidate;
+			}
+		} else if (candidate < current) {
+			if (mesh.levels[current].error * pixelsPerUnit <= errorThreshold * (1.0f + hysteresis)) {
+				candidate = current;
+			}
+		}
+
+		currentLevels[instanceIndex] = static_cast<uint8_t> (candidate);
+	}
+}
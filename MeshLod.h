@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_MESHLOD_H
+#define VULKANPROJECT_I_MESHLOD_H
+
+#include <cstdint>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include "Utilities.h"
+#include "FrustumCuller.h"
+
+
+struct MeshLevel {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset;
+	// worst case object space deviation from level 0
+	float error;
+};
+
+
+struct MeshLodChain {
+	std::vector<MeshLevel> levels;
+	BoundingSphere bounds;
+};
+
+
+struct LodInstance {
+	uint32_t meshIndex;
+	glm::vec3 position;
+	float scale;
+};
+
+
+// every level of every mesh lives in one shared vertex / index array pair,
+// so the whole library can be uploaded as a single vertex and index buffer
+class MeshLodLibrary
+{
+public:
+	static constexpr uint32_t MaxLevels = 8;
+
+	uint32_t AddMesh (const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t levelCount = MaxLevels);
+	uint32_t AddMeshChain (const std::vector<std::vector<Vertex>>& levelVertices,
+						   const std::vector<std::vector<uint32_t>>& levelIndices,
+						   const std::vector<float>& levelErrors);
+
+	const MeshLodChain& GetMesh (uint32_t meshIndex) const { return meshes.at (meshIndex); }
+	size_t GetMeshCount () const { return meshes.size (); }
+	const std::vector<Vertex>& GetVertices () const { return vertices; }
+	const std::vector<uint32_t>& GetIndices () const { return indices; }
+
+	static void SimplifyMesh (const std::vector<Vertex>& sourceVertices, const std::vector<uint32_t>& sourceIndices, float cellSize,
+							  std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices);
+
+private:
+	std::vector<MeshLodChain> meshes;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	MeshLevel AppendLevel (const std::vector<Vertex>& levelVertices, const std::vector<uint32_t>& levelIndices, float error);
+	static BoundingSphere ComputeBounds (const std::vector<Vertex>& vertices);
+	// throws unless the level is a non-empty triangle list indexing only its own vertices
+	static void ValidateLevel (const std::vector<Vertex>& levelVertices, const std::vector<uint32_t>& levelIndices);
+};
+
+
+class LodSelector
+{
+public:
+	void SetProjection (float verticalFov, float viewportHeight);
+	// pixels of projected error a level may show, and the fraction it must cross before switching again
+	void SetErrorThreshold (float pixels, float hysteresis);
+
+	void Select (const MeshLodLibrary& library,
+				 const std::vector<LodInstance>& instances,
+				 const std::vector<uint32_t>& visibleInstances,
+				 const glm::vec3& cameraPosition);
+
+	uint32_t GetLevel (uint32_t instanceIndex) const { return currentLevels[instanceIndex]; }
+
+private:
+	float projectionScale = 600.0f;
+	float errorThreshold = 1.0f;
+	float hysteresis = 0.2f;
+
+	std::vector<uint8_t> currentLevels;
+};
+
+
+#endif //VULKANPROJECT_I_MESHLOD_H
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "VulkanRenderer.h"
+
+// every heap allocation in the process goes through here, so the bench can report them per frame
+static std::atomic<uint64_t> heapAllocationCount {0};
+
+void* operator new (std::size_t size)
+{
+	heapAllocationCount.fetch_add (1, std::memory_order_relaxed);
+	if (void* memory = std::malloc (size == 0 ? 1 : size)) {
+		return memory;
+	}
+	throw std::bad_alloc ();
+}
+
+void* operator new[] (std::size_t size)
+{
+	return operator new (size);
+}
+
+void operator delete (void* memory) noexcept
+{
+	std::free (memory);
+}
+
+void operator delete[] (void* memory) noexcept
+{
+	std::free (memory);
+}
+
+void operator delete (void* memory, std::size_t) noexcept
+{
+	std::free (memory);
+}
+
+void operator delete[] (void* memory, std::size_t) noexcept
+{
+	std::free (memory);
+}
+
+
+struct BenchScenario {
+	std::string name;
+	uint32_t drawCount = 1;
+	uint32_t instancesPerDraw = 1;
+	uint32_t pipelineCount = 1;
+	VkDeviceSize uploadBytesPerFrame = 0;
+	bool resizeStorm = false;
+	bool postProcess = false;
+	// targets are rebuilt every frame, which allocates by design
+	bool allocatesPerFrame = false;
+};
+
+
+struct BenchSettings {
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	uint32_t warmupFrames = 16;
+	uint32_t frames = 500;
+	std::string scenario;
+	std::string outputPath;
+};
+
+
+struct BenchResult {
+	std::string name;
+	bool passed = false;
+	double startupMilliseconds = 0.0;
+	double setupMilliseconds = 0.0;
+	std::vector<double> frameMilliseconds;
+	std::vector<uint64_t> frameAllocations;
+	// made by the driver through the renderer's VkAllocationCallbacks
+	std::vector<uint64_t> frameHostAllocations;
+};
+
+
+static std::vector<BenchScenario> GetScenarios ()
+{
+	std::vector<BenchScenario> scenarios;
+
+	BenchScenario triangles;
+	triangles.name = "triangles_100k";
+	triangles.instancesPerDraw = 100000;
+	scenarios.push_back (triangles);
+
+	BenchScenario draws;
+	draws.name = "draws_10k";
+	draws.drawCount = 10000;
+	scenarios.push_back (draws);
+
+	BenchScenario pipelines;
+	pipelines.name = "pipelines_64";
+	pipelines.drawCount = 1024;
+	pipelines.pipelineCount = 64;
+	scenarios.push_back (pipelines);
+
+	BenchScenario resizes;
+	resizes.name = "resize_storm";
+	resizes.resizeStorm = true;
+	resizes.allocatesPerFrame = true;
+	scenarios.push_back (resizes);
+
+	BenchScenario uploads;
+	uploads.name = "upload_64mb";
+	uploads.uploadBytesPerFrame = 64ull * 1024 * 1024;
+	scenarios.push_back (uploads);
+
+	BenchScenario postProcess;
+	postProcess.name = "post_process";
+	postProcess.instancesPerDraw = 100000;
+	postProcess.postProcess = true;
+	scenarios.push_back (postProcess);
+
+	return scenarios;
+}
+
+
+static double Milliseconds (std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli> (duration).count ();
+}
+
+
+static BenchResult RunScenario (const BenchScenario& scenario, const BenchSettings& settings)
+{
+	BenchResult benchResult;
+	benchResult.name = scenario.name;
+
+	auto renderer = std::make_unique<VulkanRenderer> ();
+
+	auto startupBegin = std::chrono::steady_clock::now ();
+	if (renderer->InitHeadless (settings.width, settings.height) == EXIT_FAILURE) {
+		return benchResult;
+	}
+	benchResult.startupMilliseconds = Milliseconds (std::chrono::steady_clock::now () - startupBegin);
+
+	try {
+		auto setupBegin = std::chrono::steady_clock::now ();
+
+		renderer->ClearDraws ();
+		renderer->SetPipelineCount (scenario.pipelineCount);
+		for (uint32_t i = 0; i < scenario.drawCount; ++i) {
+			DrawCommand drawCommand {3, scenario.instancesPerDraw, 0, i % scenario.pipelineCount};
+			renderer->AddDraw (drawCommand, {{0.0f, 0.0f, 0.0f}, 0.6f}, {{-0.4f, -0.4f, 0.0f}, {0.4f, 0.4f, 0.0f}});
+		}
+		renderer->SetUploadBytesPerFrame (scenario.uploadBytesPerFrame);
+		renderer->SetPostProcessEnabled (scenario.postProcess);
+
+		benchResult.setupMilliseconds = Milliseconds (std::chrono::steady_clock::now () - setupBegin);
+
+		benchResult.frameMilliseconds.reserve (settings.frames);
+		benchResult.frameAllocations.reserve (settings.frames);
+		benchResult.frameHostAllocations.reserve (settings.frames);
+
+		for (uint32_t frame = 0; frame < settings.warmupFrames + settings.frames; ++frame) {
+			uint64_t allocationsBefore = heapAllocationCount.load (std::memory_order_relaxed);
+			uint64_t hostAllocationsBefore = GetHostAllocationCount ();
+			auto frameBegin = std::chrono::steady_clock::now ();
+
+			if (scenario.resizeStorm) {
+				uint32_t step = frame % 8;
+				renderer->Resize (settings.width - step * 64, settings.height - step * 36);
+			}
+			renderer->Update ();
+			renderer->Draw ();
+
+			auto frameEnd = std::chrono::steady_clock::now ();
+			uint64_t allocationsAfter = heapAllocationCount.load (std::memory_order_relaxed);
+			uint64_t hostAllocationsAfter = GetHostAllocationCount ();
+
+			if (frame >= settings.warmupFrames) {
+				benchResult.frameMilliseconds.push_back (Milliseconds (frameEnd - frameBegin));
+				benchResult.frameAllocations.push_back (allocationsAfter - allocationsBefore);
+				benchResult.frameHostAllocations.push_back (hostAllocationsAfter - hostAllocationsBefore);
+			}
+		}
+
+		renderer->WaitIdle ();
+
+		// after warmup every frame runs out of its arena, a heap allocation here is a regression
+		uint64_t steadyAllocations = 0;
+		for (uint64_t allocations : benchResult.frameAllocations) {
+			steadyAllocations += allocations;
+		}
+		benchResult.passed = scenario.allocatesPerFrame || steadyAllocations == 0;
+		if (!benchResult.passed) {
+			std::cerr << "Bench> " << scenario.name << ": " << steadyAllocations << " heap allocations after warmup" << std::endl;
+		}
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Error: " << scenario.name << ": " << runtimeError.what () << std::endl;
+	}
+
+	renderer->CleanUp ();
+
+	return benchResult;
+}
+
+
+static double Percentile (std::vector<double> samples, double percentile)
+{
+	if (samples.empty ()) {
+		return 0.0;
+	}
+
+	size_t index = std::min (samples.size () - 1, static_cast<size_t> (percentile / 100.0 * static_cast<double> (samples.size ())));
+	std::nth_element (samples.begin (), samples.begin () + index, samples.end ());
+	return samples[index];
+}
+
+
+static void WriteJson (std::ostream& output, const std::vector<BenchResult>& benchResults, const BenchSettings& settings)
+{
+	output << "{\n";
+	output << "  \"width\": " << settings.width << ",\n";
+	output << "  \"height\": " << settings.height << ",\n";
+	output << "  \"frames\": " << settings.frames << ",\n";
+	output << "  \"scenarios\": [\n";
+
+	for (size_t i = 0; i < benchResults.size (); ++i) {
+		const BenchResult& benchResult = benchResults[i];
+
+		uint64_t totalAllocations = 0;
+		uint64_t maxAllocations = 0;
+		for (uint64_t allocations : benchResult.frameAllocations) {
+			totalAllocations += allocations;
+			maxAllocations = std::max (maxAllocations, allocations);
+		}
+		double meanAllocations = benchResult.frameAllocations.empty () ? 0.0 :
+			static_cast<double> (totalAllocations) / static_cast<double> (benchResult.frameAllocations.size ());
+
+		uint64_t totalHostAllocations = 0;
+		uint64_t maxHostAllocations = 0;
+		for (uint64_t allocations : benchResult.frameHostAllocations) {
+			totalHostAllocations += allocations;
+			maxHostAllocations = std::max (maxHostAllocations, allocations);
+		}
+		double meanHostAllocations = benchResult.frameHostAllocations.empty () ? 0.0 :
+			static_cast<double> (totalHostAllocations) / static_cast<double> (benchResult.frameHostAllocations.size ());
+
+		output << "    {\n";
+		output << "      \"name\": \"" << benchResult.name << "\",\n";
+		output << "      \"passed\": " << (benchResult.passed ? "true" : "false") << ",\n";
+		output << "      \"startup_ms\": " << benchResult.startupMilliseconds << ",\n";
+		output << "      \"setup_ms\": " << benchResult.setupMilliseconds << ",\n";
+		output << "      \"frame_ms\": {"
+			   << "\"p50\": " << Percentile (benchResult.frameMilliseconds, 50.0) << ", "
+			   << "\"p90\": " << Percentile (benchResult.frameMilliseconds, 90.0) << ", "
+			   << "\"p99\": " << Percentile (benchResult.frameMilliseconds, 99.0) << ", "
+			   << "\"max\": " << Percentile (benchResult.frameMilliseconds, 100.0) << "},\n";
+		output << "      \"allocations_per_frame\": {"
+			   << "\"mean\": " << meanAllocations << ", "
+			   << "\"max\": " << maxAllocations << "},\n";
+		output << "      \"vulkan_host_allocations_per_frame\": {"
+			   << "\"mean\": " << meanHostAllocations << ", "
+			   << "\"max\": " << maxHostAllocations << "}\n";
+		output << "    }" << (i + 1 < benchResults.size () ? "," : "") << "\n";
+	}
+
+	output << "  ]\n";
+	output << "}\n";
+}
+
+
+static BenchSettings ParseArguments (int argc, char** argv)
+{
+	BenchSettings settings;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--frames" && hasValue) {
+			settings.frames = static_cast<uint32_t> (std::strtoul (argv[++i], nullptr, 10));
+		} else if (argument == "--width" && hasValue) {
+			settings.width = static_cast<uint32_t> (std::strtoul (argv[++i], nullptr, 10));
+		} else if (argument == "--height" && hasValue) {
+			settings.height = static_cast<uint32_t> (std::strtoul (argv[++i], nullptr, 10));
+		} else if (argument == "--scenario" && hasValue) {
+			settings.scenario = argv[++i];
+		} else if (argument == "--output" && hasValue) {
+			settings.outputPath = argv[++i];
+		} else {
+			throw std::runtime_error ("Unknown argument " + argument + "...");
+		}
+	}
+
+	// the resize storm shrinks the target by up to 7 steps
+	settings.width = std::max (settings.width, 512u);
+	settings.height = std::max (settings.height, 288u);
+
+	return settings;
+}
+
+
+int main (int argc, char** argv)
+{
+	BenchSettings settings;
+	try {
+		settings = ParseArguments (argc, argv);
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Error: " << runtimeError.what () << std::endl;
+		std::cerr << "Usage: renderer_bench [--frames N] [--width W] [--height H] [--scenario name] [--output file.json]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<BenchResult> benchResults;
+	for (const auto& scenario : GetScenarios ()) {
+		if (settings.scenario.empty () || settings.scenario == scenario.name) {
+			std::cerr << "Bench> " << scenario.name << std::endl;
+			benchResults.push_back (RunScenario (scenario, settings));
+		}
+	}
+
+	if (settings.outputPath.empty ()) {
+		WriteJson (std::cout, benchResults, settings);
+	} else {
+		std::ofstream outputFile (settings.outputPath);
+		WriteJson (outputFile, benchResults, settings);
+	}
+
+	bool allPassed = !benchResults.empty ();
+	for (const auto& benchResult : benchResults) {
+		allPassed = allPassed && benchResult.passed;
+	}
+
+	return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,291 @@
+#include "ShaderWatcher.h"
+#include "EmbeddedShaders.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define SHADERWATCHER_INOTIFY
+#endif
+
+
+void ShaderWatcher::Start (const std::string& shaderDirectory, const std::string& compilerPath)
+{
+	Stop ();
+
+	directory = shaderDirectory;
+	compiler = compilerPath;
+	if (compiler.empty ()) {
+		const char* sdkPath = std::getenv ("VULKAN_SDK");
+		compiler = sdkPath != nullptr ? (std::filesystem::path (sdkPath) / "bin" / "glslangValidator").string () : "glslangValidator";
+	}
+
+	std::error_code error;
+	if (!std::filesystem::is_directory (directory, error)) {
+		std::cerr << "Shaders> " << directory.string () << " is not a directory, hot reload disabled" << std::endl;
+		return;
+	}
+
+	// what is on disk now is what the renderer loaded, only later writes count as changes
+	std::vector<std::string> existingFiles;
+	writeTimes.clear ();
+	PollWriteTimes (existingFiles, false);
+
+	running = true;
+	watchThread = std::thread (&ShaderWatcher::WatchLoop, this);
+}
+
+
+void ShaderWatcher::Stop ()
+{
+	running = false;
+	if (watchThread.joinable ()) {
+		watchThread.join ();
+	}
+}
+
+
+ShaderWatcher::~ShaderWatcher ()
+{
+	Stop ();
+}
+
+
+bool ShaderWatcher::PollReloads (std::vector<ShaderReload>& reloads)
+{
+	std::lock_guard<std::mutex> lock (reloadMutex);
+	if (readyReloads.empty ()) {
+		return false;
+	}
+
+	for (auto& reload : readyReloads) {
+		reloads.push_back (std::move (reload));
+	}
+	readyReloads.clear ();
+
+	return true;
+}
+
+
+void ShaderWatcher::WatchLoop ()
+{
+	int inotifyDescriptor = -1;
+
+#if defined(SHADERWATCHER_INOTIFY)
+	inotifyDescriptor = pollingOnly ? -1 : inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyDescriptor >= 0 &&
+		inotify_add_watch (inotifyDescriptor, directory.c_str (), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close (inotifyDescriptor);
+		inotifyDescriptor = -1;
+	}
+	if (inotifyDescriptor < 0 && !pollingOnly) {
+		std::cerr << "Shaders> inotify unavailable, polling " << directory.string () << " instead" << std::endl;
+	}
+#endif
+
+	std::vector<std::string> changedFiles;
+	while (running) {
+		changedFiles.clear ();
+		if (!WaitForChanges (changedFiles, inotifyDescriptor)) {
+			continue;
+		}
+
+		// let the writer finish, then take everything that arrived in the meantime with it
+		std::this_thread::sleep_for (SettleTime);
+		WaitForChanges (changedFiles, inotifyDescriptor);
+
+		std::sort (changedFiles.begin (), changedFiles.end ());
+		changedFiles.erase (std::unique (changedFiles.begin (), changedFiles.end ()), changedFiles.end ());
+
+		// compile first, the SPIR-V it produces is picked up as its own change on the next pass
+		for (const auto& fileName : changedFiles) {
+			HandleChange (fileName);
+		}
+	}
+
+#if defined(SHADERWATCHER_INOTIFY)
+	if (inotifyDescriptor >= 0) {
+		close (inotifyDescriptor);
+	}
+#endif
+}
+
+
+bool ShaderWatcher::WaitForChanges (std::vector<std::string>& changedFiles, int inotifyDescriptor)
+{
+#if defined(SHADERWATCHER_INOTIFY)
+	if (inotifyDescriptor >= 0) {
+		pollfd pollDescriptor {inotifyDescriptor, POLLIN, 0};
+		if (poll (&pollDescriptor, 1, static_cast<int> (PollInterval.count ())) <= 0) {
+			return false;
+		}
+
+		alignas(inotify_event) char buffer[4096];
+		size_t changedBefore = changedFiles.size ();
+		ssize_t length;
+		while ((length = read (inotifyDescriptor, buffer, sizeof (buffer))) > 0) {
+			for (char* cursor = buffer; cursor < buffer + length; ) {
+				auto* event = reinterpret_cast<inotify_event*> (cursor);
+				if (event->len > 0 && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+					changedFiles.emplace_back (event->name);
+				}
+				cursor += sizeof (inotify_event) + event->len;
+			}
+		}
+
+		return changedFiles.size () > changedBefore;
+	}
+#endif
+
+	std::this_thread::sleep_for (PollInterval);
+	return PollWriteTimes (changedFiles);
+}
+
+
+bool ShaderWatcher::PollWriteTimes (std::vector<std::string>& changedFiles, bool reportNewFiles)
+{
+	size_t changedBefore = changedFiles.size ();
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator (directory, error)) {
+		std::string fileName = entry.path ().filename ().string ();
+		if (!IsGlslFile (fileName) && !IsSpirvFile (fileName)) {
+			continue;
+		}
+
+		auto writeTime = entry.last_write_time (error);
+		if (error) {
+			continue;
+		}
+
+		// a module compiled for the first time is new, not changed, and has to be loaded all the same
+		auto found = writeTimes.find (fileName);
+		if (found == writeTimes.end ()) {
+			writeTimes.emplace (fileName, writeTime);
+			if (reportNewFiles) {
+				changedFiles.push_back (fileName);
+			}
+		} else if (found->second != writeTime) {
+			found->second = writeTime;
+			changedFiles.push_back (fileName);
+		}
+	}
+
+	return changedFiles.size () > changedBefore;
+}
+
+
+void ShaderWatcher::HandleChange (const std::string& fileName)
+{
+	if (IsGlslFile (fileName)) {
+		CompileShader (fileName);
+		return;
+	}
+
+	if (!IsSpirvFile (fileName)) {
+		return;
+	}
+
+	std::ifstream file (directory / fileName, std::ios::binary | std::ios::ate);
+	auto byteCount = static_cast<size_t> (file.tellg ());
+
+	// a truncated or half written module is not worth handing to the driver
+	if (!file.is_open () || byteCount < 20 || byteCount % sizeof (uint32_t) != 0) {
+		std::cerr << "Shaders> " << fileName << " is not a complete SPIR-V module, skipped" << std::endl;
+		return;
+	}
+
+	// read straight into words, so the module is aligned the way vkCreateShaderModule needs it
+	std::vector<uint32_t> code (byteCount / sizeof (uint32_t));
+	file.seekg (0);
+	file.read (reinterpret_cast<char*> (code.data ()), static_cast<std::streamsize> (byteCount));
+
+	std::cout << "Shaders> reloading " << fileName << std::endl;
+
+	std::lock_guard<std::mutex> lock (reloadMutex);
+	auto pending = std::find_if (readyReloads.begin (), readyReloads.end (), [&fileName] (const ShaderReload& reload) {
+		return reload.fileName == fileName;
+	});
+	if (pending != readyReloads.end ()) {
+		pending->code = std::move (code);
+	} else {
+		readyReloads.push_back ({fileName, std::move (code)});
+	}
+}
+
+
+void ShaderWatcher::CompileShader (const std::string& fileName)
+{
+	// every module embed_shader () built from this file, each with its own defines
+	std::vector<const EmbeddedShader*> variants = FindEmbeddedShaderVariants (fileName);
+	if (variants.empty ()) {
+		// not embedded, so nothing loads it by name yet; same output name glslangValidator picks
+		// by default: the stage, e.g. shader.geom -> geom.spv
+		std::string stage = std::filesystem::path (fileName).extension ().string ().substr (1);
+		CompileVariant (fileName, stage + ".spv", "");
+		return;
+	}
+
+	for (const auto* variant : variants) {
+		CompileVariant (fileName, variant->fileName, variant->defines);
+	}
+}
+
+
+void ShaderWatcher::CompileVariant (const std::string& fileName, const std::string& outputName, const std::string& defines)
+{
+	std::filesystem::path source = directory / fileName;
+	std::filesystem::path output = directory / outputName;
+	std::filesystem::path temporary = directory / (outputName + ".tmp");
+
+	std::string defineArguments;
+	std::istringstream defineStream (defines);
+	std::string define;
+	while (defineStream >> define) {
+		defineArguments += " -D" + define;
+	}
+
+	std::string command = "\"" + compiler + "\" -V" + defineArguments + " \"" + source.string () + "\" -o \"" + temporary.string () + "\"";
+	int status = std::system (command.c_str ());
+
+	std::error_code error;
+	if (status != 0) {
+		std::cerr << "Shaders> compiling " << outputName << " from " << fileName << " failed, keeping the previous one" << std::endl;
+		std::filesystem::remove (temporary, error);
+		return;
+	}
+
+	// the rename is atomic, so the reload never sees a partially written module
+	std::filesystem::rename (temporary, output, error);
+	if (error) {
+		std::cerr << "Shaders> could not replace " << output.string () << ": " << error.message () << std::endl;
+		return;
+	}
+
+	std::cout << "Shaders> compiled " << outputName << " from " << fileName << std::endl;
+}
+
+
+bool ShaderWatcher::IsGlslFile (const std::string& fileName)
+{
+	static const char* stages[] = {".vert", ".frag", ".comp", ".geom", ".tesc", ".tese"};
+
+	std::string extension = std::filesystem::path (fileName).extension ().string ();
+	return std::any_of (std::begin (stages), std::end (stages), [&extension] (const char* stage) {
+		return extension == stage;
+	});
+}
+
+
+bool ShaderWatcher::IsSpirvFile (const std::string& fileName)
+{
+	return std::filesystem::path (fileName).extension () == ".spv";
+}
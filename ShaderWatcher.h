@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_SHADERWATCHER_H
+#define VULKANPROJECT_I_SHADERWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct ShaderReload {
+	// SPIR-V file name without directory, e.g. "frag.spv"
+	std::string fileName;
+	std::vector<uint32_t> code;
+};
+
+
+// watches a shader directory on a background thread; changed GLSL is compiled next to it into
+// every module embed_shader () builds from it, with the same defines and file names, and every
+// changed SPIR-V file is read and queued for the render loop to pick up at a frame boundary.
+// Reloaded modules replace the embedded ones by that file name
+class ShaderWatcher
+{
+public:
+	// editors save through several writes and renames, events closer together than this are merged
+	static constexpr std::chrono::milliseconds SettleTime {50};
+	static constexpr std::chrono::milliseconds PollInterval {250};
+
+	ShaderWatcher () = default;
+	ShaderWatcher (const ShaderWatcher&) = delete;
+	ShaderWatcher& operator= (const ShaderWatcher&) = delete;
+
+	// compilerPath defaults to glslangValidator from $VULKAN_SDK, or the one on PATH
+	void Start (const std::string& shaderDirectory, const std::string& compilerPath = "");
+	// before Start: compare write times even where inotify is available, for tests and file
+	// systems that send no change events
+	void SetPollingOnly (bool enabled) { pollingOnly = enabled; }
+	void Stop ();
+
+	// moves every reload that is ready into reloads, returns false when there was none
+	bool PollReloads (std::vector<ShaderReload>& reloads);
+
+	~ShaderWatcher ();
+
+private:
+	std::filesystem::path directory;
+	std::string compiler;
+
+	std::thread watchThread;
+	std::atomic<bool> running {false};
+	bool pollingOnly = false;
+
+	std::mutex reloadMutex;
+	std::vector<ShaderReload> readyReloads;
+
+	// last seen write times, only used by the polling fallback
+	std::map<std::string, std::filesystem::file_time_type> writeTimes;
+
+	void WatchLoop ();
+	bool WaitForChanges (std::vector<std::string>& changedFiles, int inotifyDescriptor);
+	// files not seen before count as changed, except on the first scan
+	bool PollWriteTimes (std::vector<std::string>& changedFiles, bool reportNewFiles = true);
+	void HandleChange (const std::string& fileName);
+	void CompileShader (const std::string& fileName);
+	void CompileVariant (const std::string& fileName, const std::string& outputName, const std::string& defines);
+
+	static bool IsGlslFile (const std::string& fileName);
+	static bool IsSpirvFile (const std::string& fileName);
+};
+
+
+#endif //VULKANPROJECT_I_SHADERWATCHER_H
@@ -1,2 +0,0 @@
-/Users/elyxAir/VulkanSDK/1.2.198.1/macOS/bin/glslangValidator -V shader.vert
-/Users/elyxAir/VulkanSDK/1.2.198.1/macOS/bin/glslangValidator -V shader.frag
@@ -1,9 +1,44 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+// set per pipeline through SpecializationConstants, see ShaderConstantId in Utilities.h
+layout (constant_id = 1) const bool Grayscale = false;
+
 layout (location = 0) in vec3 fragColor;
 layout (location = 0) out vec4 outColor;
 
+#ifdef BINDLESS
+// the renderer's bindless heap, see BindlessHeap.h
+layout (set = 0, binding = 0) uniform sampler2D textures[];
+layout (set = 0, binding = 1) readonly buffer Material {
+    vec4 tint;
+} materials[];
+
+// DrawCommand::textureIndex and materialIndex
+layout (push_constant) uniform DrawIndices {
+    uint textureIndex;
+    uint materialIndex;
+} drawIndices;
+#endif
+
 void main ()
 {
-    outColor = vec4 (fragColor, 1.0);
-}
\ No newline at end of file
+    vec3 color = fragColor;
+
+#ifdef BINDLESS
+    // the indices are the same for the whole draw, so they need no nonuniformEXT
+    vec2 textureCoordinate = gl_FragCoord.xy / vec2 (textureSize (textures[drawIndices.textureIndex], 0));
+    color *= texture (textures[drawIndices.textureIndex], textureCoordinate).rgb;
+    color *= materials[drawIndices.materialIndex].tint.rgb;
+#endif
+
+    if (Grayscale) {
+        float luminance = dot (color, vec3 (0.2126, 0.7152, 0.0722));
+        outColor = vec4 (vec3 (luminance), 1.0);
+    } else {
+        outColor = vec4 (color, 1.0);
+    }
+}
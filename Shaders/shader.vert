@@ -1,5 +1,7 @@
 #version 450
 
+// set per pipeline through SpecializationConstants, see ShaderConstantId in Utilities.h
+layout (constant_id = 0) const float Scale = 1.0;
 
 layout (location = 0) out vec3 fragColor;
 
@@ -20,6 +22,6 @@ vec3 colors[3] = vec3[] (
 
 void main ()
 {
-    gl_Position = vec4 (positions[gl_VertexIndex], 1.0);
+    gl_Position = vec4 (positions[gl_VertexIndex] * Scale, 1.0);
     fragColor = colors[gl_VertexIndex];
 }
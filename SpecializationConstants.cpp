@@ -0,0 +1,73 @@
+#include "SpecializationConstants.h"
+
+#include <algorithm>
+
+
+void SpecializationConstants::SetWord (uint32_t constantId, uint32_t word)
+{
+	auto found = std::lower_bound (entries.begin (), entries.end (), constantId, [] (const VkSpecializationMapEntry& entry, uint32_t id) {
+		return entry.constantID < id;
+	});
+	size_t index = static_cast<size_t> (found - entries.begin ());
+
+	if (found != entries.end () && found->constantID == constantId) {
+		data[index] = word;
+		return;
+	}
+
+	entries.insert (found, {constantId, 0, sizeof (uint32_t)});
+	data.insert (data.begin () + static_cast<std::ptrdiff_t> (index), word);
+
+	// offsets move with every insertion, they are only final once the set is complete
+	for (size_t i = index; i < entries.size (); ++i) {
+		entries[i].offset = static_cast<uint32_t> (i * sizeof (uint32_t));
+	}
+}
+
+
+uint64_t SpecializationConstants::GetHash () const
+{
+	// FNV-1a over (id, value) pairs, which are kept sorted so equal sets hash equally
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash] (uint32_t word) {
+		for (int byte = 0; byte < 4; ++byte) {
+			hash ^= (word >> (byte * 8)) & 0xFFu;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	for (size_t i = 0; i < entries.size (); ++i) {
+		mix (entries[i].constantID);
+		mix (data[i]);
+	}
+
+	return hash;
+}
+
+
+VkSpecializationInfo SpecializationConstants::GetInfo () const
+{
+	VkSpecializationInfo specializationInfo {};
+	specializationInfo.mapEntryCount = static_cast<uint32_t> (entries.size ());
+	specializationInfo.pMapEntries = entries.data ();
+	specializationInfo.dataSize = data.size () * sizeof (uint32_t);
+	specializationInfo.pData = data.data ();
+
+	return specializationInfo;
+}
+
+
+bool SpecializationConstants::operator== (const SpecializationConstants& other) const
+{
+	if (data != other.data || entries.size () != other.entries.size ()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < entries.size (); ++i) {
+		if (entries[i].constantID != other.entries[i].constantID) {
+			return false;
+		}
+	}
+
+	return true;
+}
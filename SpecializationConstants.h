@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_SPECIALIZATIONCONSTANTS_H
+#define VULKANPROJECT_I_SPECIALIZATIONCONSTANTS_H
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+// values for a shader's layout (constant_id = N) constants, baked in when the pipeline is created
+// so the driver can fold them and drop dead branches; one SPIR-V module serves every variant
+class SpecializationConstants
+{
+public:
+	// 32 bit scalars only, which covers every GLSL specialization constant type but double
+	template <typename T>
+	void Set (uint32_t constantId, T value)
+	{
+		static_assert (std::is_arithmetic<T>::value && sizeof (T) == sizeof (uint32_t),
+					   "Specialization constants are int, uint or float; use the bool overload for bool");
+		uint32_t word;
+		std::memcpy (&word, &value, sizeof (word));
+		SetWord (constantId, word);
+	}
+
+	// GLSL bool constants are 32 bit VkBool32 on the API side
+	void Set (uint32_t constantId, bool value) { SetWord (constantId, value ? VK_TRUE : VK_FALSE); }
+
+	bool IsEmpty () const { return entries.empty (); }
+	// depends only on the constants, not on the order they were set in
+	uint64_t GetHash () const;
+
+	// points into this object, which has to outlive the pipeline creation that uses it
+	VkSpecializationInfo GetInfo () const;
+
+	bool operator== (const SpecializationConstants& other) const;
+	bool operator!= (const SpecializationConstants& other) const { return !(*this == other); }
+
+private:
+	// sorted by constantID, entry i describes data[i]
+	std::vector<VkSpecializationMapEntry> entries;
+	std::vector<uint32_t> data;
+
+	void SetWord (uint32_t constantId, uint32_t word);
+};
+
+
+#endif //VULKANPROJECT_I_SPECIALIZATIONCONSTANTS_H
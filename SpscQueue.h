@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_SPSCQUEUE_H
+#define VULKANPROJECT_I_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+// fixed size ring between exactly one producer and one consumer thread. Neither side locks,
+// waits or allocates; pushing into a full queue fails and leaves the choice to the producer
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert (Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity has to be a power of two...");
+
+public:
+	// producer thread only
+	bool TryPush (const T& value)
+	{
+		size_t writeIndex = writePosition.load (std::memory_order_relaxed);
+		if (writeIndex - cachedReadPosition == Capacity) {
+			cachedReadPosition = readPosition.load (std::memory_order_acquire);
+			if (writeIndex - cachedReadPosition == Capacity) {
+				return false;
+			}
+		}
+
+		slots[writeIndex & (Capacity - 1)] = value;
+		writePosition.store (writeIndex + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer thread only
+	bool TryPop (T& value)
+	{
+		size_t readIndex = readPosition.load (std::memory_order_relaxed);
+		if (readIndex == cachedWritePosition) {
+			cachedWritePosition = writePosition.load (std::memory_order_acquire);
+			if (readIndex == cachedWritePosition) {
+				return false;
+			}
+		}
+
+		value = slots[readIndex & (Capacity - 1)];
+		readPosition.store (readIndex + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	// each side's position and its copy of the other one on their own cache line, so the two
+	// threads only share a line when one actually has to look at the other's progress
+	static constexpr size_t CacheLineSize = 64;
+
+	alignas (CacheLineSize) std::atomic<size_t> writePosition {0};
+	size_t cachedReadPosition = 0;
+
+	alignas (CacheLineSize) std::atomic<size_t> readPosition {0};
+	size_t cachedWritePosition = 0;
+
+	alignas (CacheLineSize) std::array<T, Capacity> slots {};
+};
+
+
+#endif //VULKANPROJECT_I_SPSCQUEUE_H
@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BatchRenderer.h"
+
+// renders a batch on every Vulkan device the loader finds, lavapipe included, and checks the
+// frames come back complete and in job order, also when the consumer gives up half way
+
+// ctest treats this as skipped rather than failed
+static constexpr int SkipReturnCode = 77;
+
+static constexpr uint32_t FrameSize = 64;
+static constexpr size_t JobCount = 24;
+
+
+// even jobs show the triangle, odd ones move it out of view and must come out clear
+static std::vector<BatchJob> MakeJobs ()
+{
+	std::vector<BatchJob> jobs;
+	for (size_t jobIndex = 0; jobIndex < JobCount; ++jobIndex) {
+		jobs.push_back ({[jobIndex] (VulkanRenderer& renderer) {
+			glm::mat4 viewProjection (1.0f);
+			viewProjection[3][0] = jobIndex % 2 == 0 ? 0.0f : 5.0f;
+			renderer.SetViewProjection (viewProjection);
+		}});
+	}
+
+	return jobs;
+}
+
+
+static bool CheckFrame (size_t jobIndex, const Image& image)
+{
+	if (image.width != FrameSize || image.height != FrameSize || image.pixels.size () != FrameSize * FrameSize * 4) {
+		std::cerr << "Batch> job " << jobIndex << ": frame is " << image.width << "x" << image.height << std::endl;
+		return false;
+	}
+
+	// the corner is always clear, the center only when the triangle was culled
+	const uint8_t* corner = image.pixels.data ();
+	const uint8_t* center = image.pixels.data () + (FrameSize / 2 * FrameSize + FrameSize / 2) * 4;
+	bool centerClear = std::memcmp (corner, center, 4) == 0;
+
+	if (centerClear != (jobIndex % 2 == 1)) {
+		std::cerr << "Batch> job " << jobIndex << ": got the frame of another job" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+int main ()
+{
+	BatchRenderer batchRenderer;
+	if (batchRenderer.Init (FrameSize, FrameSize) == EXIT_FAILURE) {
+		std::cout << "Batch> no Vulkan device, skipping" << std::endl;
+		return SkipReturnCode;
+	}
+
+	std::vector<BatchJob> jobs = MakeJobs ();
+	bool passed = true;
+
+	size_t nextJob = 0;
+	batchRenderer.Render (jobs, [&passed, &nextJob] (size_t jobIndex, const Image& image) {
+		if (jobIndex != nextJob) {
+			std::cerr << "Batch> job " << jobIndex << " handed over, expected " << nextJob << std::endl;
+			passed = false;
+		}
+		passed = CheckFrame (jobIndex, image) && passed;
+		nextJob = jobIndex + 1;
+	});
+	passed = passed && nextJob == JobCount;
+
+	for (size_t deviceIndex = 0; deviceIndex < batchRenderer.GetDeviceCount (); ++deviceIndex) {
+		std::cout << "Batch> " << batchRenderer.GetDeviceName (deviceIndex) << ": "
+				  << batchRenderer.GetJobsRendered (deviceIndex) << " jobs" << std::endl;
+	}
+
+	// a consumer that throws has to come back out of Render, with the workers joined
+	bool rethrown = false;
+	try {
+		batchRenderer.Render (jobs, [] (size_t jobIndex, const Image&) {
+			if (jobIndex == 3) {
+				throw std::runtime_error ("Consumer gave up...");
+			}
+		});
+	} catch (const std::runtime_error&) {
+		rethrown = true;
+	}
+	if (!rethrown) {
+		std::cerr << "Batch> the consumer's exception did not reach the caller" << std::endl;
+		passed = false;
+	}
+
+	// and the renderer stays usable, without jobs left over from the cancelled batch
+	size_t frameCount = 0;
+	batchRenderer.Render (jobs, [&passed, &frameCount] (size_t jobIndex, const Image& image) {
+		passed = CheckFrame (jobIndex, image) && passed;
+		++frameCount;
+	});
+	passed = passed && frameCount == JobCount;
+
+	batchRenderer.CleanUp ();
+
+	std::cout << "Batch> " << (passed ? "passed" : "failed") << std::endl;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
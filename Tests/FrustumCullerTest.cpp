@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FrustumCuller.h"
+
+// checks the SIMD path the culler was built with (SSE, AVX or NEON) against a scalar double
+// precision reference, no Vulkan involved. Built once per instruction set by CMakeLists.txt
+
+// ctest treats this as skipped rather than failed
+static constexpr int SkipReturnCode = 77;
+
+
+struct TestObject {
+	BoundingSphere sphere;
+	BoundingBox box;
+};
+
+
+// clip = (x, y, a * z + b, z): a frustum looking down +z with 90 degree fovs, near 1 and far 100
+static constexpr double Near = 1.0;
+static constexpr double Far = 100.0;
+static constexpr double DepthScale = Far / (Far - Near);
+static constexpr double DepthOffset = -Far * Near / (Far - Near);
+
+// the same planes written out by hand, normalized, inside is >= 0
+static const double ReferencePlanes[6][4] = {
+	{ 1.0, 0.0, 1.0, 0.0},
+	{-1.0, 0.0, 1.0, 0.0},
+	{ 0.0, 1.0, 1.0, 0.0},
+	{ 0.0, -1.0, 1.0, 0.0},
+	{ 0.0, 0.0, 1.0, -Near},
+	{ 0.0, 0.0, -1.0, Far}
+};
+
+// the SIMD paths add in a different order, so results this close to a plane may legitimately differ
+static constexpr double Ambiguity = 1e-3;
+
+
+static glm::mat4 GetViewProjection ()
+{
+	glm::mat4 viewProjection (1.0f);
+	viewProjection[2][2] = static_cast<float> (DepthScale);
+	viewProjection[3][2] = static_cast<float> (DepthOffset);
+	viewProjection[2][3] = 1.0f;
+	viewProjection[3][3] = 0.0f;
+	return viewProjection;
+}
+
+
+static double GetPlaneDistance (int p, double x, double y, double z)
+{
+	const double* plane = ReferencePlanes[p];
+	double length = std::sqrt (plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+	return (plane[0] * x + plane[1] * y + plane[2] * z + plane[3]) / length;
+}
+
+
+// false if the object sits so close to a plane that float rounding may decide either way
+static bool CullReference (const TestObject& object, bool& visible)
+{
+	visible = true;
+	bool certain = true;
+
+	for (int p = 0; p < 6; ++p) {
+		const double* plane = ReferencePlanes[p];
+		double sphereMargin = GetPlaneDistance (p, object.sphere.center.x, object.sphere.center.y, object.sphere.center.z) + object.sphere.radius;
+		double boxMargin = GetPlaneDistance (p,
+											 plane[0] >= 0.0 ? object.box.max.x : object.box.min.x,
+											 plane[1] >= 0.0 ? object.box.max.y : object.box.min.y,
+											 plane[2] >= 0.0 ? object.box.max.z : object.box.min.z);
+
+		certain = certain && std::abs (sphereMargin) > Ambiguity && std::abs (boxMargin) > Ambiguity;
+		visible = visible && sphereMargin >= 0.0 && boxMargin >= 0.0;
+	}
+
+	return certain;
+}
+
+
+static TestObject MakeObject (float x, float y, float z, float radius)
+{
+	// the largest box the sphere still encloses
+	float halfExtent = radius / std::sqrt (3.0f);
+	return {{{x, y, z}, radius}, {{x - halfExtent, y - halfExtent, z - halfExtent}, {x + halfExtent, y + halfExtent, z + halfExtent}}};
+}
+
+
+static std::vector<TestObject> MakeObjects (size_t count, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> lateral (-150.0f, 150.0f);
+	std::uniform_real_distribution<float> depth (-20.0f, 120.0f);
+	std::uniform_real_distribution<float> radius (0.0f, 10.0f);
+	std::uniform_int_distribution<int> plane (0, 5);
+
+	std::vector<TestObject> objects;
+	objects.reserve (count);
+
+	for (size_t i = 0; i < count; ++i) {
+		// every third object straddles one of the planes
+		if (i % 3 == 0) {
+			float z = std::uniform_real_distribution<float> (5.0f, 95.0f) (random);
+			float lateralOffset = std::uniform_real_distribution<float> (-0.5f, 0.5f) (random) * z;
+			switch (plane (random)) {
+				case 0: objects.push_back (MakeObject (-z, lateralOffset, z, 2.0f)); break;
+				case 1: objects.push_back (MakeObject (z, lateralOffset, z, 2.0f)); break;
+				case 2: objects.push_back (MakeObject (lateralOffset, -z, z, 2.0f)); break;
+				case 3: objects.push_back (MakeObject (lateralOffset, z, z, 2.0f)); break;
+				case 4: objects.push_back (MakeObject (lateralOffset * 0.01f, lateralOffset * 0.01f, static_cast<float> (Near), 0.5f)); break;
+				default: objects.push_back (MakeObject (lateralOffset, lateralOffset, static_cast<float> (Far), 2.0f)); break;
+			}
+		} else {
+			objects.push_back (MakeObject (lateral (random), lateral (random), depth (random), radius (random)));
+		}
+	}
+
+	return objects;
+}
+
+
+static bool CheckCount (size_t count, unsigned int threadCount, FrustumCuller& culler, std::mt19937& random)
+{
+	std::vector<TestObject> objects = MakeObjects (count, random);
+
+	culler.Clear ();
+	for (const auto& object : objects) {
+		culler.AddObject (object.sphere, object.box);
+	}
+
+	std::vector<uint32_t> visibleObjects;
+	culler.Cull (visibleObjects, threadCount);
+
+	std::string name = std::to_string (count) + " objects, " + std::to_string (threadCount) + " threads";
+
+	if (!std::is_sorted (visibleObjects.begin (), visibleObjects.end ()) ||
+		std::adjacent_find (visibleObjects.begin (), visibleObjects.end ()) != visibleObjects.end ()) {
+		std::cerr << name << ": visible objects are not strictly ascending" << std::endl;
+		return false;
+	}
+
+	size_t visibleCount = 0;
+	size_t next = 0;
+	for (size_t i = 0; i < count; ++i) {
+		bool culledVisible = next < visibleObjects.size () && visibleObjects[next] == i;
+		if (culledVisible) {
+			++next;
+		}
+
+		bool referenceVisible;
+		if (CullReference (objects[i], referenceVisible) && culledVisible != referenceVisible) {
+			std::cerr << name << ": object " << i << " is " << (culledVisible ? "visible" : "culled")
+					  << ", the reference says " << (referenceVisible ? "visible" : "culled") << std::endl;
+			return false;
+		}
+		visibleCount += culledVisible ? 1 : 0;
+	}
+
+	// anything left over is a padding lane or an index from outside the range
+	if (next != visibleObjects.size ()) {
+		std::cerr << name << ": object " << visibleObjects[next] << " reported, only " << count << " exist" << std::endl;
+		return false;
+	}
+
+	std::cout << name << ": " << visibleCount << " visible" << std::endl;
+	return true;
+}
+
+
+// padding lanes sit at the origin and have to stay culled even when the origin is inside
+static bool CheckPadding (FrustumCuller& culler)
+{
+	glm::mat4 everything (1.0f);
+	everything[0][0] = 1e-6f;
+	everything[1][1] = 1e-6f;
+	everything[2][2] = 1e-6f;
+	everything[3][2] = 0.5f;
+	culler.SetViewProjection (everything);
+
+	bool passed = true;
+	for (size_t count = 1; count < 2 * FrustumCuller::BatchWidth; ++count) {
+		culler.Clear ();
+		for (size_t i = 0; i < count; ++i) {
+			TestObject object = MakeObject (0.0f, 0.0f, 0.0f, 1.0f);
+			culler.AddObject (object.sphere, object.box);
+		}
+
+		std::vector<uint32_t> visibleObjects;
+		culler.Cull (visibleObjects);
+		if (visibleObjects.size () != count || visibleObjects.back () != count - 1) {
+			std::cerr << "padding, " << count << " objects: " << visibleObjects.size () << " reported visible" << std::endl;
+			passed = false;
+		}
+	}
+
+	culler.SetViewProjection (GetViewProjection ());
+	return passed;
+}
+
+
+int main ()
+{
+#if defined(__AVX__) && (defined(__GNUC__) || defined(__clang__))
+	if (!__builtin_cpu_supports ("avx")) {
+		std::cout << "Culling> built for AVX, which this CPU lacks, skipping" << std::endl;
+		return SkipReturnCode;
+	}
+#endif
+
+	std::cout << "Culling> batch width " << FrustumCuller::BatchWidth << std::endl;
+
+	FrustumCuller culler;
+	std::mt19937 random (1234);
+
+	bool passed = CheckPadding (culler);
+
+	// around every batch boundary, then enough objects for several chunks
+	for (size_t count = 0; count <= 3 * FrustumCuller::BatchWidth + 1; ++count) {
+		passed = CheckCount (count, 1, culler, random) && passed;
+	}
+	passed = CheckCount (1000, 1, culler, random) && passed;
+	passed = CheckCount (1001, 1, culler, random) && passed;
+
+	// the same culler again and again, so the worker pool is reused with more and fewer chunks
+	size_t manyObjects = 3 * FrustumCuller::MinObjectsPerThread + 5;
+	for (unsigned int threadCount : {4u, 2u, 8u, 3u, 1u, 4u}) {
+		passed = CheckCount (manyObjects, threadCount, culler, random) && passed;
+	}
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,253 @@
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VulkanRenderer.h"
+#include "ImageDiff.h"
+#include "ImageIO.h"
+
+#ifndef GOLDEN_IMAGE_DIR
+#define GOLDEN_IMAGE_DIR "Tests/Golden"
+#endif
+
+// ctest treats this as skipped rather than failed
+static constexpr int SkipReturnCode = 77;
+
+
+struct GoldenScene {
+	std::string name;
+	std::function<void (VulkanRenderer&)> setUp;
+};
+
+
+struct GoldenSettings {
+	uint32_t width = 256;
+	uint32_t height = 256;
+	uint8_t tolerance = 2;
+	bool update = false;
+	std::string scene;
+	std::string goldenDirectory = GOLDEN_IMAGE_DIR;
+	std::string outputDirectory = ".";
+};
+
+
+static std::vector<GoldenScene> GetScenes ()
+{
+	std::vector<GoldenScene> scenes;
+
+	scenes.push_back ({"triangle", [] (VulkanRenderer&) {}});
+
+	scenes.push_back ({"clear_only", [] (VulkanRenderer& renderer) {
+		renderer.ClearDraws ();
+	}});
+
+	// the same triangle drawn through several pipeline variants, which must not change the output
+	scenes.push_back ({"pipeline_variants", [] (VulkanRenderer& renderer) {
+		renderer.ClearDraws ();
+		renderer.SetPipelineCount (4);
+		for (uint32_t i = 0; i < 16; ++i) {
+			DrawCommand drawCommand {3, 1, 0, i % 4};
+			renderer.AddDraw (drawCommand, {{0.0f, 0.0f, 0.0f}, 0.6f}, {{-0.4f, -0.4f, 0.0f}, {0.4f, 0.4f, 0.0f}});
+		}
+	}});
+
+	// moves the view so the triangle's bounds are outside the frustum, the frame must come out clear
+	scenes.push_back ({"culled", [] (VulkanRenderer& renderer) {
+		glm::mat4 viewProjection (1.0f);
+		viewProjection[3][0] = 5.0f;
+		renderer.SetViewProjection (viewProjection);
+	}});
+
+	// one module, specialized into a larger grayscale triangle at pipeline creation
+	scenes.push_back ({"specialized", [] (VulkanRenderer& renderer) {
+		SpecializationConstants vertexConstants;
+		vertexConstants.Set (VertexScaleConstant, 1.5f);
+		SpecializationConstants fragmentConstants;
+		fragmentConstants.Set (FragmentGrayscaleConstant, true);
+
+		renderer.ClearDraws ();
+		DrawCommand drawCommand {3, 1, 0, renderer.AddSpecializedPipeline (vertexConstants, fragmentConstants)};
+		renderer.AddDraw (drawCommand, {{0.0f, 0.0f, 0.0f}, 0.9f}, {{-0.6f, -0.6f, 0.0f}, {0.6f, 0.6f, 0.0f}});
+	}});
+
+	// the triangle with the compute vignette applied after the graphics pass
+	scenes.push_back ({"post_process", [] (VulkanRenderer& renderer) {
+		renderer.SetPostProcessEnabled (true, 0.8f);
+	}});
+
+	// the triangle tinted through a texture and a material picked by index from the bindless heap
+	scenes.push_back ({"bindless", [] (VulkanRenderer& renderer) {
+		renderer.ClearDraws ();
+		DrawCommand drawCommand {3, 1, 0, renderer.AddBindlessPipeline ()};
+		drawCommand.textureIndex = renderer.AddSolidTexture ({1.0f, 0.5f, 1.0f, 1.0f});
+		drawCommand.materialIndex = renderer.AddMaterial ({0.5f, 1.0f, 1.0f, 1.0f});
+		renderer.AddDraw (drawCommand, {{0.0f, 0.0f, 0.0f}, 0.6f}, {{-0.4f, -0.4f, 0.0f}, {0.4f, 0.4f, 0.0f}});
+	}});
+
+	return scenes;
+}
+
+
+static bool RenderScene (const GoldenScene& scene, const GoldenSettings& settings, Image& image)
+{
+	auto renderer = std::make_unique<VulkanRenderer> ();
+	if (renderer->InitHeadless (settings.width, settings.height) == EXIT_FAILURE) {
+		return false;
+	}
+
+	bool rendered = false;
+	try {
+		scene.setUp (*renderer);
+
+		// cycle every offscreen target once so the captured frame is not the first use of anything
+		for (size_t frame = 0; frame < MaxFrameDraws + 1; ++frame) {
+			renderer->Update ();
+			renderer->Draw ();
+		}
+
+		renderer->CaptureFrame (image);
+		rendered = true;
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Error: " << scene.name << ": " << runtimeError.what () << std::endl;
+	}
+
+	renderer->CleanUp ();
+
+	return rendered;
+}
+
+
+enum class SceneResult {
+	Passed,
+	Failed,
+	Skipped
+};
+
+
+static SceneResult CheckScene (const GoldenScene& scene, const GoldenSettings& settings)
+{
+	Image actual;
+	if (!RenderScene (scene, settings, actual)) {
+		return SceneResult::Failed;
+	}
+
+	std::string goldenPath = settings.goldenDirectory + "/" + scene.name + ".rgba";
+
+	if (settings.update) {
+		WriteRawImage (goldenPath, actual);
+		std::cout << "Golden> " << scene.name << ": updated " << goldenPath << std::endl;
+		return SceneResult::Passed;
+	}
+
+	Image expected;
+	try {
+		if (!ReadRawImage (goldenPath, expected)) {
+			std::cout << "Golden> " << scene.name << ": no golden image, run with --update to create it" << std::endl;
+			return SceneResult::Skipped;
+		}
+	} catch (const std::runtime_error& runtimeError) {
+		std::cout << "Golden> " << scene.name << ": " << runtimeError.what () << std::endl;
+		return SceneResult::Failed;
+	}
+
+	if (expected.width != actual.width || expected.height != actual.height) {
+		std::cout << "Golden> " << scene.name << ": size " << actual.width << "x" << actual.height
+				  << " does not match golden " << expected.width << "x" << expected.height << std::endl;
+		return SceneResult::Failed;
+	}
+
+	size_t pixelCount = static_cast<size_t> (actual.width) * actual.height;
+	ImageDiffResult diffResult = DiffImages (expected.pixels.data (), actual.pixels.data (), pixelCount,
+											 settings.tolerance, std::thread::hardware_concurrency ());
+
+	if (diffResult.mismatchedPixels == 0) {
+		std::cout << "Golden> " << scene.name << ": passed" << std::endl;
+		return SceneResult::Passed;
+	}
+
+	std::cout << "Golden> " << scene.name << ": " << diffResult.mismatchedPixels << " of " << pixelCount
+			  << " pixels differ, max channel difference " << static_cast<int> (diffResult.maxChannelDifference) << std::endl;
+
+	Image heatmap;
+	heatmap.width = actual.width;
+	heatmap.height = actual.height;
+	BuildDiffHeatmap (expected.pixels.data (), actual.pixels.data (), pixelCount, settings.tolerance, heatmap.pixels);
+
+	WritePng (settings.outputDirectory + "/" + scene.name + "_actual.png", actual);
+	WritePng (settings.outputDirectory + "/" + scene.name + "_diff.png", heatmap);
+
+	return SceneResult::Failed;
+}
+
+
+static GoldenSettings ParseArguments (int argc, char** argv)
+{
+	GoldenSettings settings;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--update") {
+			settings.update = true;
+		} else if (argument == "--scene" && hasValue) {
+			settings.scene = argv[++i];
+		} else if (argument == "--tolerance" && hasValue) {
+			settings.tolerance = static_cast<uint8_t> (std::strtoul (argv[++i], nullptr, 10));
+		} else if (argument == "--golden-dir" && hasValue) {
+			settings.goldenDirectory = argv[++i];
+		} else if (argument == "--output-dir" && hasValue) {
+			settings.outputDirectory = argv[++i];
+		} else {
+			throw std::runtime_error ("Unknown argument " + argument + "...");
+		}
+	}
+
+	return settings;
+}
+
+
+int main (int argc, char** argv)
+{
+	GoldenSettings settings;
+	try {
+		settings = ParseArguments (argc, argv);
+	} catch (const std::runtime_error& runtimeError) {
+		std::cerr << "Error: " << runtimeError.what () << std::endl;
+		std::cerr << "Usage: renderer_golden [--update] [--scene name] [--tolerance N] [--golden-dir dir] [--output-dir dir]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	size_t failedCount = 0;
+	size_t skippedCount = 0;
+	size_t sceneCount = 0;
+
+	for (const auto& scene : GetScenes ()) {
+		if (!settings.scene.empty () && settings.scene != scene.name) {
+			continue;
+		}
+
+		++sceneCount;
+		switch (CheckScene (scene, settings)) {
+			case SceneResult::Passed:
+				break;
+			case SceneResult::Failed:
+				++failedCount;
+				break;
+			case SceneResult::Skipped:
+				++skippedCount;
+				break;
+		}
+	}
+
+	if (sceneCount == 0 || failedCount > 0) {
+		return EXIT_FAILURE;
+	}
+
+	return skippedCount > 0 ? SkipReturnCode : EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ImageDiff.h"
+
+// checks the SIMD path DiffImages was built with (SSE2, AVX2 or NEON) against a plain scalar
+// loop, no Vulkan involved. Built once per instruction set by CMakeLists.txt
+
+// ctest treats this as skipped rather than failed
+static constexpr int SkipReturnCode = 77;
+
+
+static ImageDiffResult DiffReference (const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual, uint8_t tolerance)
+{
+	ImageDiffResult diffResult;
+	for (size_t pixel = 0; pixel < expected.size () / 4; ++pixel) {
+		bool mismatched = false;
+		for (size_t channel = 0; channel < 4; ++channel) {
+			int difference = std::abs (expected[pixel * 4 + channel] - actual[pixel * 4 + channel]);
+			diffResult.maxChannelDifference = std::max (diffResult.maxChannelDifference, static_cast<uint8_t> (difference));
+			mismatched = mismatched || difference > tolerance;
+		}
+		diffResult.mismatchedPixels += mismatched ? 1 : 0;
+	}
+
+	return diffResult;
+}
+
+
+// actual is expected with some channels moved by exactly the tolerance, one more than it, or
+// by the most a byte can move, in both directions
+static void MakeImages (size_t pixelCount, uint8_t tolerance, std::mt19937& random, std::vector<uint8_t>& expected, std::vector<uint8_t>& actual)
+{
+	std::uniform_int_distribution<int> byte (0, 255);
+	std::uniform_int_distribution<int> change (0, 7);
+
+	expected.resize (pixelCount * 4);
+	actual.resize (pixelCount * 4);
+
+	for (size_t i = 0; i < expected.size (); ++i) {
+		int value = byte (random);
+		int offset = 0;
+		switch (change (random)) {
+			case 0: offset = tolerance; break;
+			case 1: offset = -tolerance; break;
+			case 2: offset = tolerance + 1; break;
+			case 3: offset = -(tolerance + 1); break;
+			case 4: value = 0; offset = 255; break;
+			case 5: value = 255; offset = -255; break;
+			default: break;
+		}
+
+		expected[i] = static_cast<uint8_t> (value);
+		actual[i] = static_cast<uint8_t> (std::clamp (value + offset, 0, 255));
+	}
+}
+
+
+static bool CheckImages (const std::string& name, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual,
+						 uint8_t tolerance, unsigned int threadCount)
+{
+	size_t pixelCount = expected.size () / 4;
+	ImageDiffResult reference = DiffReference (expected, actual, tolerance);
+	ImageDiffResult diffResult = DiffImages (expected.data (), actual.data (), pixelCount, tolerance, threadCount);
+
+	if (diffResult.mismatchedPixels != reference.mismatchedPixels || diffResult.maxChannelDifference != reference.maxChannelDifference) {
+		std::cerr << name << ": " << diffResult.mismatchedPixels << " mismatched, max " << static_cast<int> (diffResult.maxChannelDifference)
+				  << ", the reference says " << reference.mismatchedPixels << ", max " << static_cast<int> (reference.maxChannelDifference) << std::endl;
+		return false;
+	}
+
+	// the heatmap marks exactly the mismatched pixels
+	std::vector<uint8_t> heatmap;
+	BuildDiffHeatmap (expected.data (), actual.data (), pixelCount, tolerance, heatmap);
+	uint64_t markedPixels = 0;
+	for (size_t pixel = 0; pixel < pixelCount; ++pixel) {
+		markedPixels += heatmap[pixel * 4] != 0 ? 1 : 0;
+	}
+	if (markedPixels != reference.mismatchedPixels) {
+		std::cerr << name << ": heatmap marks " << markedPixels << " pixels, " << reference.mismatchedPixels << " mismatch" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+// one pixel off by exactly the tolerance or one more, at every position of a row, so each
+// SIMD lane and each tail pixel gets its turn
+static bool CheckSinglePixel (size_t pixelCount, uint8_t tolerance)
+{
+	bool passed = true;
+	std::vector<uint8_t> expected (pixelCount * 4, 100);
+
+	for (size_t pixel = 0; pixel < pixelCount; ++pixel) {
+		for (int extra : {0, 1}) {
+			std::vector<uint8_t> actual = expected;
+			actual[pixel * 4 + pixel % 4] = static_cast<uint8_t> (100 + tolerance + extra);
+
+			std::string name = std::to_string (pixelCount) + " pixels, pixel " + std::to_string (pixel) + " off by tolerance + " + std::to_string (extra);
+			passed = CheckImages (name, expected, actual, tolerance, 1) && passed;
+		}
+	}
+
+	return passed;
+}
+
+
+int main ()
+{
+#if defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+	if (!__builtin_cpu_supports ("avx2")) {
+		std::cout << "ImageDiff> built for AVX2, which this CPU lacks, skipping" << std::endl;
+		return SkipReturnCode;
+	}
+#endif
+
+	std::mt19937 random (4321);
+	std::vector<uint8_t> expected;
+	std::vector<uint8_t> actual;
+	bool passed = true;
+
+	// every count up to a few AVX2 blocks, so each possible tail length follows the SIMD loop
+	for (uint8_t tolerance : {0, 2, 254, 255}) {
+		for (size_t pixelCount = 0; pixelCount <= 35; ++pixelCount) {
+			MakeImages (pixelCount, tolerance, random, expected, actual);
+			std::string name = std::to_string (pixelCount) + " pixels, tolerance " + std::to_string (tolerance);
+			passed = CheckImages (name, expected, actual, tolerance, 1) && passed;
+		}
+	}
+
+	for (uint8_t tolerance : {0, 2, 127}) {
+		passed = CheckSinglePixel (19, tolerance) && passed;
+	}
+
+	// large enough to be split across threads, with chunks that do not end on a SIMD block
+	size_t largeCount = 3 * (1 << 18) + 7;
+	MakeImages (largeCount, 2, random, expected, actual);
+	for (unsigned int threadCount : {1u, 3u, 8u}) {
+		passed = CheckImages (std::to_string (largeCount) + " pixels, " + std::to_string (threadCount) + " threads", expected, actual, 2, threadCount) && passed;
+	}
+
+	std::cout << "ImageDiff> " << (passed ? "passed" : "failed") << std::endl;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
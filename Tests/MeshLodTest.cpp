@@ -0,0 +1,283 @@
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MeshLod.h"
+
+// clustering output of MeshLodLibrary and level switching of LodSelector, no Vulkan device needed
+
+
+static bool Check (bool condition, const std::string& message)
+{
+	if (!condition) {
+		std::cerr << message << std::endl;
+	}
+
+	return condition;
+}
+
+
+// size x size vertices spaced 1 / size apart, offset by half a spacing so no vertex sits on a
+// clustering cell boundary
+static void MakeGrid (uint32_t size, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	float spacing = 1.0f / static_cast<float> (size);
+	for (uint32_t y = 0; y < size; ++y) {
+		for (uint32_t x = 0; x < size; ++x) {
+			glm::vec3 position ((static_cast<float> (x) + 0.5f) * spacing, (static_cast<float> (y) + 0.5f) * spacing, 0.0f);
+			vertices.push_back ({position, glm::vec3 (static_cast<float> (x % 2), static_cast<float> (y % 2), 1.0f)});
+		}
+	}
+
+	for (uint32_t y = 0; y + 1 < size; ++y) {
+		for (uint32_t x = 0; x + 1 < size; ++x) {
+			uint32_t corner = y * size + x;
+			indices.insert (indices.end (), {corner, corner + 1, corner + size, corner + 1, corner + size + 1, corner + size});
+		}
+	}
+}
+
+
+static bool CheckSimplify ()
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MakeGrid (32, vertices, indices);
+
+	std::vector<Vertex> outVertices;
+	std::vector<uint32_t> outIndices;
+	bool passed = true;
+
+	// cells smaller than the spacing keep the mesh as it is
+	MeshLodLibrary::SimplifyMesh (vertices, indices, 0.5f / 32.0f, outVertices, outIndices);
+	passed = Check (outVertices.size () == vertices.size () && outIndices.size () == indices.size (), "fine cells changed the mesh") && passed;
+
+	// two spacings per cell: 2 x 2 vertices per cluster, placed on their average
+	MeshLodLibrary::SimplifyMesh (vertices, indices, 2.0f / 32.0f, outVertices, outIndices);
+	passed = Check (outVertices.size () == 16 * 16, "2x2 clustering gave " + std::to_string (outVertices.size ()) + " vertices") && passed;
+	passed = Check (!outIndices.empty () && outIndices.size () < indices.size (), "2x2 clustering did not drop triangles") && passed;
+
+	bool averaged = true;
+	for (const auto& vertex : outVertices) {
+		// every cluster holds one even and one odd column and row, centered between them
+		float cellX = vertex.position.x * 16.0f - 0.5f;
+		float cellY = vertex.position.y * 16.0f - 0.5f;
+		averaged = averaged && std::abs (cellX - std::round (cellX)) < 1e-4f && std::abs (cellY - std::round (cellY)) < 1e-4f;
+		averaged = averaged && std::abs (vertex.color.x - 0.5f) < 1e-4f && std::abs (vertex.color.y - 0.5f) < 1e-4f;
+	}
+	passed = Check (averaged, "clusters are not the average of their vertices") && passed;
+
+	bool validTriangles = outIndices.size () % 3 == 0;
+	for (size_t i = 0; i + 2 < outIndices.size (); i += 3) {
+		uint32_t a = outIndices[i];
+		uint32_t b = outIndices[i + 1];
+		uint32_t c = outIndices[i + 2];
+		validTriangles = validTriangles && a < outVertices.size () && b < outVertices.size () && c < outVertices.size ();
+		validTriangles = validTriangles && a != b && b != c && a != c;
+	}
+	passed = Check (validTriangles, "clustering left degenerate or out of range triangles") && passed;
+
+	// one cell for everything collapses every triangle
+	MeshLodLibrary::SimplifyMesh (vertices, indices, 4.0f, outVertices, outIndices);
+	passed = Check (outVertices.size () == 1 && outIndices.empty (), "a single cell left triangles behind") && passed;
+
+	return passed;
+}
+
+
+static bool CheckLibrary ()
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	// denser than the first 64 cell clustering grid, so every level has something to merge
+	MakeGrid (128, vertices, indices);
+
+	MeshLodLibrary library;
+	uint32_t meshIndex = library.AddMesh (vertices, indices);
+	const MeshLodChain& mesh = library.GetMesh (meshIndex);
+
+	bool passed = Check (mesh.levels.size () > 2, "only " + std::to_string (mesh.levels.size ()) + " levels for a 128x128 grid");
+	passed = Check (mesh.levels[0].indexCount == indices.size () && mesh.levels[0].error == 0.0f, "level 0 is not the source mesh") && passed;
+
+	const auto& libraryVertices = library.GetVertices ();
+	const auto& libraryIndices = library.GetIndices ();
+
+	for (size_t level = 0; level < mesh.levels.size (); ++level) {
+		const MeshLevel& meshLevel = mesh.levels[level];
+		size_t vertexEnd = level + 1 < mesh.levels.size () ? mesh.levels[level + 1].vertexOffset : libraryVertices.size ();
+		std::string name = "level " + std::to_string (level);
+
+		if (level > 0) {
+			const MeshLevel& finer = mesh.levels[level - 1];
+			passed = Check (meshLevel.indexCount <= finer.indexCount * 9 / 10, name + " saves less than a tenth of the indices") && passed;
+			passed = Check (meshLevel.error > finer.error, name + " error does not grow") && passed;
+		}
+
+		bool inRange = meshLevel.indexCount > 0;
+		for (uint32_t i = 0; i < meshLevel.indexCount; ++i) {
+			size_t vertex = meshLevel.vertexOffset + libraryIndices[meshLevel.firstIndex + i];
+			inRange = inRange && vertex < vertexEnd;
+		}
+		passed = Check (inRange, name + " indexes outside its own vertices") && passed;
+
+		// clusters average their vertices, so they never leave the bounds
+		bool bounded = true;
+		for (size_t vertex = meshLevel.vertexOffset; vertex < vertexEnd; ++vertex) {
+			bounded = bounded && glm::distance (libraryVertices[vertex].position, mesh.bounds.center) <= mesh.bounds.radius * 1.0001f;
+		}
+		passed = Check (bounded, name + " has vertices outside the bounds") && passed;
+	}
+
+	return passed;
+}
+
+
+static bool Throws (const std::function<void ()>& function)
+{
+	try {
+		function ();
+	} catch (const std::runtime_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+
+// bad input is rejected before clustering reads past the vertices, and leaves the library as it was
+static bool CheckValidation ()
+{
+	std::vector<Vertex> triangle = {
+		{{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}},
+		{{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}},
+		{{0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}
+	};
+
+	MeshLodLibrary library;
+	bool passed = Check (Throws ([&] { library.AddMesh (triangle, {0, 1}); }), "AddMesh took a partial triangle");
+	passed = Check (Throws ([&] { library.AddMesh (triangle, {0, 1, 3}); }), "AddMesh took an index past the vertices") && passed;
+	passed = Check (Throws ([&] { library.AddMesh ({}, {}); }), "AddMesh took a mesh without vertices") && passed;
+
+	passed = Check (Throws ([&] { library.AddMeshChain ({triangle, triangle}, {{0, 1, 2}, {0, 1}}, {0.0f, 0.1f}); }),
+					"AddMeshChain took a partial triangle in level 1") && passed;
+	passed = Check (Throws ([&] { library.AddMeshChain ({triangle, triangle}, {{0, 1, 2}, {0, 1, 3}}, {0.0f, 0.1f}); }),
+					"AddMeshChain took an index past the vertices of level 1") && passed;
+	passed = Check (Throws ([&] { library.AddMeshChain ({triangle, {}}, {{0, 1, 2}, {}}, {0.0f, 0.1f}); }),
+					"AddMeshChain took a level without vertices") && passed;
+
+	passed = Check (library.GetVertices ().empty () && library.GetIndices ().empty (), "rejected meshes left data behind") && passed;
+	passed = Check (!Throws ([&] { library.AddMeshChain ({triangle, triangle}, {{0, 1, 2}, {2, 1, 0}}, {0.0f, 0.1f}); }),
+					"AddMeshChain rejected a valid chain") && passed;
+
+	return passed;
+}
+
+
+// one triangle per level with known errors; bounds center (0, 0.5, 0), radius sqrt (1.25)
+static uint32_t AddKnownChain (MeshLodLibrary& library)
+{
+	std::vector<Vertex> triangle = {
+		{{-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}},
+		{{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}},
+		{{0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}
+	};
+
+	return library.AddMeshChain ({triangle, triangle, triangle, triangle}, {{0, 1, 2}, {0, 1, 2}, {0, 1, 2}, {0, 1, 2}}, {0.0f, 0.01f, 0.02f, 0.04f});
+}
+
+
+// places the camera so that distance minus bounds radius, what LodSelector divides by, is gap
+static uint32_t SelectAt (LodSelector& selector, const MeshLodLibrary& library, const std::vector<LodInstance>& instances, float gap)
+{
+	const BoundingSphere& bounds = library.GetMesh (0).bounds;
+	glm::vec3 cameraPosition = bounds.center + glm::vec3 (0.0f, 0.0f, bounds.radius + gap);
+
+	selector.Select (library, instances, {0}, cameraPosition);
+	return selector.GetLevel (0);
+}
+
+
+static bool CheckHysteresis ()
+{
+	MeshLodLibrary library;
+	AddKnownChain (library);
+	std::vector<LodInstance> instances = {{0, glm::vec3 (0.0f), 1.0f}};
+
+	// 600 pixels per unit at distance 1; level n is allowed once error n * 600 / gap <= 1 pixel
+	LodSelector selector;
+	selector.SetProjection (2.0f * std::atan (0.5f), 600.0f);
+	selector.SetErrorThreshold (1.0f, 0.2f);
+
+	// going out a level is only taken at 0.8 pixels (gaps 7.5, 15, 30), coming back only past
+	// 1.2 pixels (gaps 5, 10, 20). Gaps are stepped so no sample lands on a threshold
+	const float outward[] = {7.5f, 15.0f, 30.0f};
+	const float inward[] = {20.0f, 10.0f, 5.0f};
+	bool passed = true;
+
+	uint32_t level = SelectAt (selector, library, instances, 1.125f);
+	passed = Check (level == 0, "close up does not start at level 0") && passed;
+
+	size_t switchCount = 0;
+	for (int step = 1; step < 160; ++step) {
+		float previousGap = 1.125f + 0.25f * static_cast<float> (step - 1);
+		float gap = previousGap + 0.25f;
+		uint32_t newLevel = SelectAt (selector, library, instances, gap);
+		if (newLevel != level) {
+			bool expected = switchCount < 3 && newLevel == level + 1 && previousGap < outward[switchCount] && outward[switchCount] <= gap;
+			passed = Check (expected, "going out switched to level " + std::to_string (newLevel) + " at gap " + std::to_string (gap)) && passed;
+			++switchCount;
+			level = newLevel;
+		}
+	}
+	passed = Check (switchCount == 3 && level == 3, "going out did not reach the coarsest level") && passed;
+
+	switchCount = 0;
+	for (int step = 158; step >= 0; --step) {
+		float previousGap = 1.125f + 0.25f * static_cast<float> (step + 1);
+		float gap = previousGap - 0.25f;
+		uint32_t newLevel = SelectAt (selector, library, instances, gap);
+		if (newLevel != level) {
+			bool expected = switchCount < 3 && newLevel + 1 == level && gap < inward[switchCount] && inward[switchCount] <= previousGap;
+			passed = Check (expected, "coming in switched to level " + std::to_string (newLevel) + " at gap " + std::to_string (gap)) && passed;
+			++switchCount;
+			level = newLevel;
+		}
+	}
+	passed = Check (switchCount == 3 && level == 0, "coming in did not return to level 0") && passed;
+
+	// wobbling around the plain 1 pixel threshold at gap 6 keeps whichever level it had
+	for (float gap : {5.75f, 6.25f, 5.75f, 6.25f, 7.25f, 5.25f}) {
+		passed = Check (SelectAt (selector, library, instances, gap) == 0, "level 0 flipped at gap " + std::to_string (gap)) && passed;
+	}
+	SelectAt (selector, library, instances, 8.0f);
+	for (float gap : {6.25f, 5.75f, 6.25f, 5.75f, 5.25f, 7.25f}) {
+		passed = Check (SelectAt (selector, library, instances, gap) == 1, "level 1 flipped at gap " + std::to_string (gap)) && passed;
+	}
+
+	// without hysteresis the same wobble switches every time
+	selector.SetErrorThreshold (1.0f, 0.0f);
+	passed = Check (SelectAt (selector, library, instances, 5.75f) == 0, "no hysteresis kept level 1 at gap 5.75") && passed;
+	passed = Check (SelectAt (selector, library, instances, 6.25f) == 1, "no hysteresis kept level 0 at gap 6.25") && passed;
+
+	// an instance in view for the first time far away gets the coarsest level at once
+	LodSelector freshSelector;
+	passed = Check (SelectAt (freshSelector, library, instances, 5000.0f) == 3, "a sub pixel object is not at the coarsest level") && passed;
+
+	return passed;
+}
+
+
+int main ()
+{
+	bool passed = CheckSimplify ();
+	passed = CheckLibrary () && passed;
+	passed = CheckValidation () && passed;
+	passed = CheckHysteresis () && passed;
+
+	std::cout << "MeshLod> " << (passed ? "passed" : "failed") << std::endl;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ShaderWatcher.h"
+
+// edits shader.frag in a scratch directory through the polling fallback, with a stand-in for
+// glslangValidator that copies the source, and checks every module built from it is reloaded,
+// also the first time it appears on disk. No Vulkan device needed
+
+// ctest treats this as skipped rather than failed
+static constexpr int SkipReturnCode = 77;
+
+static constexpr std::chrono::seconds ReloadTimeout {10};
+
+
+// called as <compiler> -V [-D<define>...] <source> -o <output>
+static const char* FakeCompiler =
+	"#!/bin/sh\n"
+	"while [ $# -gt 0 ]; do\n"
+	"\tcase \"$1\" in\n"
+	"\t\t-o) output=\"$2\"; shift ;;\n"
+	"\t\t-V|-D*) ;;\n"
+	"\t\t*) source=\"$1\" ;;\n"
+	"\tesac\n"
+	"\tshift\n"
+	"done\n"
+	"cp \"$source\" \"$output\"\n";
+
+
+// 32 bytes, so the copy passes as a complete module
+static std::string MakeSource (int version)
+{
+	std::string source = "// version " + std::to_string (version);
+	source.resize (31, ' ');
+	return source + "\n";
+}
+
+
+// moves the write time well past the last one, coarse file system clocks would miss the edit
+static void WriteSource (const std::filesystem::path& path, int version)
+{
+	{
+		std::ofstream file (path, std::ios::binary | std::ios::trunc);
+		file << MakeSource (version);
+	}
+	std::filesystem::last_write_time (path, std::filesystem::file_time_type::clock::now () + std::chrono::seconds (2 * version));
+}
+
+
+// waits until every expected module came back with the source of that version
+static bool WaitForReloads (ShaderWatcher& watcher, const std::vector<std::string>& fileNames, int version)
+{
+	std::string expected = MakeSource (version);
+	std::vector<std::string> pending = fileNames;
+
+	auto deadline = std::chrono::steady_clock::now () + ReloadTimeout;
+	while (!pending.empty () && std::chrono::steady_clock::now () < deadline) {
+		std::vector<ShaderReload> reloads;
+		if (!watcher.PollReloads (reloads)) {
+			std::this_thread::sleep_for (std::chrono::milliseconds (20));
+			continue;
+		}
+
+		for (const auto& reload : reloads) {
+			std::string code (reinterpret_cast<const char*> (reload.code.data ()), reload.code.size () * sizeof (uint32_t));
+			if (code != expected) {
+				std::cerr << "Shaders> " << reload.fileName << " reloaded with an older source" << std::endl;
+				continue;
+			}
+			pending.erase (std::remove (pending.begin (), pending.end (), reload.fileName), pending.end ());
+		}
+	}
+
+	for (const auto& fileName : pending) {
+		std::cerr << "Shaders> edit " << version << " never reloaded " << fileName << std::endl;
+	}
+	return pending.empty ();
+}
+
+
+int main ()
+{
+#if defined(_WIN32)
+	std::cout << "Shaders> the stand-in compiler is a shell script, skipping" << std::endl;
+	return SkipReturnCode;
+#endif
+
+	std::mt19937 random (std::random_device {} ());
+	std::filesystem::path directory = std::filesystem::temp_directory_path () / ("shader_watcher_test_" + std::to_string (random ()));
+	std::filesystem::create_directories (directory);
+
+	std::filesystem::path compiler = directory / "compiler.sh";
+	{
+		std::ofstream file (compiler);
+		file << FakeCompiler;
+	}
+	std::filesystem::permissions (compiler, std::filesystem::perms::owner_all);
+
+	// only the GLSL is there at first, as in a fresh checkout
+	WriteSource (directory / "shader.frag", 1);
+
+	ShaderWatcher watcher;
+	watcher.SetPollingOnly (true);
+	watcher.Start (directory.string (), compiler.string ());
+
+	// the first edit creates the modules, the second replaces them
+	const std::vector<std::string> modules = {"frag.spv", "frag_bindless.spv"};
+	bool passed = true;
+	for (int version : {2, 3}) {
+		WriteSource (directory / "shader.frag", version);
+		passed = WaitForReloads (watcher, modules, version) && passed;
+	}
+
+	watcher.Stop ();
+
+	std::error_code error;
+	std::filesystem::remove_all (directory, error);
+
+	std::cout << "Shaders> " << (passed ? "passed" : "failed") << std::endl;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+#include "TimelineSemaphore.h"
+
+#include <stdexcept>
+
+
+void TimelineSemaphore::Create (VkDevice newDevice, const VkAllocationCallbacks* newAllocator)
+{
+	device = newDevice;
+	allocator = newAllocator;
+	lastSubmittedValue = 0;
+
+	VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo {};
+	semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphoreTypeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+	VkResult result = vkCreateSemaphore (device, &semaphoreCreateInfo, allocator, &semaphore);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a timeline semaphore...");
+	}
+}
+
+
+void TimelineSemaphore::Destroy ()
+{
+	if (semaphore != VK_NULL_HANDLE) {
+		vkDestroySemaphore (device, semaphore, allocator);
+		semaphore = VK_NULL_HANDLE;
+	}
+}
+
+
+uint64_t TimelineSemaphore::GetCompletedValue () const
+{
+	uint64_t value = 0;
+	VkResult result = vkGetSemaphoreCounterValue (device, semaphore, &value);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to read a timeline semaphore...");
+	}
+
+	return value;
+}
+
+
+bool TimelineSemaphore::Wait (uint64_t value, uint64_t timeout) const
+{
+	VkSemaphoreWaitInfo waitInfo {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+
+	VkResult result = vkWaitSemaphores (device, &waitInfo, timeout);
+	if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+		throw std::runtime_error ("Failed to wait on a timeline semaphore...");
+	}
+
+	return result == VK_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#ifndef VULKANPROJECT_I_TIMELINESEMAPHORE_H
+#define VULKANPROJECT_I_TIMELINESEMAPHORE_H
+
+#include <cstdint>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+
+// one per queue; every submit to the queue signals the next value, so waiting for value N
+// waits for that submit and everything submitted before it (Vulkan 1.2)
+class TimelineSemaphore
+{
+public:
+	void Create (VkDevice newDevice, const VkAllocationCallbacks* newAllocator = nullptr);
+	void Destroy ();
+
+	// reserves the value the next submit on this queue will signal
+	uint64_t NextValue () { return ++lastSubmittedValue; }
+	uint64_t GetLastSubmittedValue () const { return lastSubmittedValue; }
+	uint64_t GetCompletedValue () const;
+
+	bool Wait (uint64_t value, uint64_t timeout) const;
+
+	VkSemaphore GetSemaphore () const { return semaphore; }
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	const VkAllocationCallbacks* allocator = nullptr;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	uint64_t lastSubmittedValue = 0;
+};
+
+
+#endif //VULKANPROJECT_I_TIMELINESEMAPHORE_H
@@ -3,11 +3,22 @@
 #ifndef VULKANPROJECT_I_UTILITIES_H
 #define VULKANPROJECT_I_UTILITIES_H
 
-#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SpecializationConstants.h"
 
 
 constexpr int MaxFrameDraws = 2;
 
+// GLSL sources, only read by hot reload; the build embeds the compiled shaders
+#ifndef SHADER_SOURCE_DIR
+#define SHADER_SOURCE_DIR "../Shaders"
+#endif
+constexpr const char* ShaderDirectory = SHADER_SOURCE_DIR;
+
 
 const std::vector<const char*> deviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -17,6 +28,9 @@ const std::vector<const char*> deviceExtensions = {
 struct QueueFamilyIndices {
 	int graphicsFamily = -1;
 	int presentationFamily = -1;
+	// a compute only family when there is one, so compute work overlaps the graphics queue;
+	// otherwise the graphics family. Not required, features needing it check for -1
+	int computeFamily = -1;
 
 	bool IsValid () {
 		return graphicsFamily >= 0 && presentationFamily >= 0;
@@ -37,25 +51,92 @@ struct SwapchainImage {
 };
 
 
-static std::vector<char> ReadFile (const std::string& fileName)
-{
-	std::ifstream file (fileName, std::ios::binary | std::ios::ate);
+struct ShaderModule {
+	// SPIR-V file the module came from, hot reload matches on it
+	std::string fileName;
+	VkShaderModule module;
+};
 
-	if (!file.is_open()) {
-		throw std::runtime_error ("Failed to open a file...");
-	}
 
-	size_t fileSize = static_cast<size_t> (file.tellg ());
-	std::vector<char> fileBuffer (fileSize);
+// constant_id values declared in Shaders/, keep the two in sync
+enum ShaderConstantId : uint32_t {
+	VertexScaleConstant = 0,		// float, scales the triangle about the origin
+	FragmentGrayscaleConstant = 1,	// bool, outputs luminance instead of color
+	ComputeGroupWidthConstant = 2,	// uint, local_size_x of compute shaders
+	ComputeGroupHeightConstant = 3,	// uint, local_size_y of compute shaders
+	PostProcessVignetteConstant = 4	// float, how much postprocess.comp darkens the corners
+};
+
+
+struct GraphicsPipeline {
+	VkPipeline pipeline;
+	uint32_t variant;
+	// indices into the renderer's shader modules
+	uint32_t vertexModule;
+	uint32_t fragmentModule;
+	SpecializationConstants vertexConstants;
+	SpecializationConstants fragmentConstants;
+	// covers everything above but the pipeline handle, equal state means an equal pipeline
+	uint64_t stateHash;
+};
+
 
-	file.seekg (0);
+struct ComputePipeline {
+	VkPipeline pipeline;
+	// owned by the pipeline, built from the bindings it was added with
+	VkDescriptorSetLayout setLayout;
+	VkPipelineLayout layout;
+	// index into the renderer's shader modules
+	uint32_t shaderModule;
+	SpecializationConstants constants;
+	// the local size set through constants, dispatches are counted in these
+	uint32_t groupWidth;
+	uint32_t groupHeight;
+};
 
-	file.read (fileBuffer.data (), fileSize);
 
-	file.close ();
+enum class ComputeQueue {
+	// before the frame's render pass, so the draws of the same frame see the results
+	Graphics,
+	// after the frame's render pass on the compute queue, overlapping the next frame's rendering
+	Compute
+};
 
-	return fileBuffer;
-}
+
+struct ComputeDispatch {
+	uint32_t pipelineIndex;
+	// allocated for the same pipeline, VK_NULL_HANDLE when the pipeline has no bindings
+	VkDescriptorSet descriptorSet;
+	// invocations, rounded up to whole groups
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth = 1;
+	ComputeQueue queue = ComputeQueue::Graphics;
+};
+
+
+struct Vertex {
+	glm::vec3 position;
+	glm::vec3 color;
+};
+
+
+struct DrawCommand {
+	uint32_t vertexCount;
+	uint32_t instanceCount;
+	uint32_t firstVertex;
+	uint32_t pipelineIndex;
+	// bindless heap entries, pushed per draw; only read by bindless pipelines
+	uint32_t textureIndex = 0;
+	uint32_t materialIndex = 0;
+};
+
+
+// push constant block of the bindless fragment shader
+struct DrawIndices {
+	uint32_t textureIndex;
+	uint32_t materialIndex;
+};
 
 
 #endif //VULKANPROJECT_I_UTILITIES_H
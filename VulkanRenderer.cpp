@@ -1,62 +1,988 @@
 #include "VulkanRenderer.h"
+#include "AsyncLogger.h"
+#include "EmbeddedShaders.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+static uint64_t HashPipelineState (const GraphicsPipeline& graphicsPipeline)
+{
+	uint64_t hash = graphicsPipeline.vertexConstants.GetHash ();
+	for (uint64_t value : {graphicsPipeline.fragmentConstants.GetHash (), uint64_t {graphicsPipeline.variant},
+						   uint64_t {graphicsPipeline.vertexModule}, uint64_t {graphicsPipeline.fragmentModule}}) {
+		hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+	}
+
+	return hash;
+}
+
 
 VulkanRenderer::VulkanRenderer ()
 {
+	frameReadbackSlots.fill (-1);
+	hostAllocator = GetHostAllocationCallbacks ();
 }
 
 
 int VulkanRenderer::InitRenderer (GLFWwindow *newWindow)
 {
 	window = newWindow;
+	headless = false;
+
+	return InitVulkan ();
+}
+
 
+int VulkanRenderer::InitHeadless (uint32_t width, uint32_t height)
+{
+	window = nullptr;
+	headless = true;
+	headlessExtent = {width, height};
+
+	return InitVulkan ();
+}
+
+
+int VulkanRenderer::InitVulkan ()
+{
 	try {
 		CreateInstance ();
-		CreateSurface ();
+		if (!headless) {
+			CreateSurface ();
+		}
 		GetPhysicalDevice ();
 		CreateLogicalDevice ();
-		CreateSwapchain ();
+		if (headless) {
+			CreateOffscreenTargets ();
+		} else {
+			CreateSwapchain ();
+		}
 		CreateRenderPass ();
+		CreateBindlessHeap ();
 		CreateGraphicsPipeline ();
+		CreateComputePipelines ();
 		CreateFrameBuffers ();
+		CreatePostProcessDescriptors ();
 		CreateCommandPool ();
 		CreateCommandBuffers ();
-		RecordCommands ();
 		CreateSynchronization ();
+		if (useBindless) {
+			// index 0 of each, which every draw reads until it picks others
+			AddSolidTexture (glm::vec4 (1.0f));
+			AddMaterial (glm::vec4 (1.0f));
+		}
 	} catch (const std::runtime_error& runtimeError) {
 		std::cerr << "Error: " << runtimeError.what () << std::endl;
+		CleanUp ();
 		return EXIT_FAILURE;
 	}
 
+	cullingThreadCount = std::max (1u, std::thread::hardware_concurrency ());
+
+	// the triangle hardcoded in shader.vert
+	DrawCommand triangle {3, 1, 0, 0};
+	AddDraw (triangle, {{0.0f, 0.0f, 0.0f}, 0.4f * std::sqrt (2.0f)}, {{-0.4f, -0.4f, 0.0f}, {0.4f, 0.4f, 0.0f}});
+	SetViewProjection (glm::mat4 (1.0f));
+
 	return 0;
 }
 
 
+uint32_t VulkanRenderer::AddDraw (const DrawCommand& drawCommand, const BoundingSphere& sphere, const BoundingBox& box)
+{
+	if (drawCommand.pipelineIndex >= graphicsPipelines.size ()) {
+		throw std::out_of_range ("Draw pipeline index out of range...");
+	}
+
+	drawCommands.push_back (drawCommand);
+	return frustumCuller.AddObject (sphere, box);
+}
+
+
+void VulkanRenderer::ClearDraws ()
+{
+	drawCommands.clear ();
+	visibleDraws.clear ();
+	frustumCuller.Clear ();
+}
+
+
+void VulkanRenderer::SetViewProjection (const glm::mat4& viewProjection)
+{
+	frustumCuller.SetViewProjection (viewProjection);
+}
+
+
+void VulkanRenderer::SetPipelineCount (uint32_t pipelineCount)
+{
+	pipelineCount = std::max (pipelineCount, 1u);
+
+	// check everything before removing anything, a refused trim leaves the list as it was
+	for (size_t i = pipelineCount; i < graphicsPipelines.size (); ++i) {
+		if (graphicsPipelines[i].variant == 0) {
+			throw std::runtime_error ("Only pipeline variants can be trimmed, a specialized or bindless pipeline is in the way...");
+		}
+	}
+	for (const auto& drawCommand : drawCommands) {
+		if (drawCommand.pipelineIndex >= pipelineCount) {
+			throw std::runtime_error ("A draw still uses a pipeline that would be trimmed...");
+		}
+	}
+
+	while (graphicsPipelines.size () > pipelineCount) {
+		DestroyDeferred (graphicsPipelines.back ().pipeline);
+		graphicsPipelines.pop_back ();
+	}
+	while (graphicsPipelines.size () < pipelineCount) {
+		// new variants use the same shaders as the first one
+		GraphicsPipeline graphicsPipeline = graphicsPipelines.front ();
+		graphicsPipeline.variant = static_cast<uint32_t> (graphicsPipelines.size ());
+		graphicsPipeline.stateHash = HashPipelineState (graphicsPipeline);
+		graphicsPipeline.pipeline = CreateGraphicsPipelineVariant (graphicsPipeline,
+																   shaderModules[graphicsPipeline.vertexModule].module,
+																   shaderModules[graphicsPipeline.fragmentModule].module);
+		graphicsPipelines.push_back (graphicsPipeline);
+	}
+}
+
+
+uint32_t VulkanRenderer::AddSpecializedPipeline (const SpecializationConstants& vertexConstants, const SpecializationConstants& fragmentConstants)
+{
+	GraphicsPipeline graphicsPipeline = graphicsPipelines.front ();
+	graphicsPipeline.vertexConstants = vertexConstants;
+	graphicsPipeline.fragmentConstants = fragmentConstants;
+
+	return FindOrAddGraphicsPipeline (graphicsPipeline);
+}
+
+
+uint32_t VulkanRenderer::AddBindlessPipeline (const SpecializationConstants& vertexConstants, const SpecializationConstants& fragmentConstants)
+{
+	if (!useBindless) {
+		throw std::runtime_error ("Bindless pipelines need descriptor indexing support...");
+	}
+
+	GraphicsPipeline graphicsPipeline = graphicsPipelines.front ();
+	graphicsPipeline.fragmentModule = bindlessFragmentModule;
+	graphicsPipeline.vertexConstants = vertexConstants;
+	graphicsPipeline.fragmentConstants = fragmentConstants;
+
+	return FindOrAddGraphicsPipeline (graphicsPipeline);
+}
+
+
+uint32_t VulkanRenderer::FindOrAddGraphicsPipeline (GraphicsPipeline graphicsPipeline)
+{
+	graphicsPipeline.stateHash = HashPipelineState (graphicsPipeline);
+
+	for (size_t i = 0; i < graphicsPipelines.size (); ++i) {
+		const GraphicsPipeline& existing = graphicsPipelines[i];
+		if (existing.stateHash == graphicsPipeline.stateHash &&
+			existing.variant == graphicsPipeline.variant &&
+			existing.vertexModule == graphicsPipeline.vertexModule &&
+			existing.fragmentModule == graphicsPipeline.fragmentModule &&
+			existing.vertexConstants == graphicsPipeline.vertexConstants &&
+			existing.fragmentConstants == graphicsPipeline.fragmentConstants)
+		{
+			return static_cast<uint32_t> (i);
+		}
+	}
+
+	graphicsPipeline.pipeline = CreateGraphicsPipelineVariant (graphicsPipeline,
+															   shaderModules[graphicsPipeline.vertexModule].module,
+															   shaderModules[graphicsPipeline.fragmentModule].module);
+	graphicsPipelines.push_back (graphicsPipeline);
+
+	return static_cast<uint32_t> (graphicsPipelines.size () - 1);
+}
+
+
+uint32_t VulkanRenderer::AddSolidTexture (const glm::vec4& color)
+{
+	if (!useBindless) {
+		throw std::runtime_error ("Bindless resources need descriptor indexing support...");
+	}
+
+	VkImageCreateInfo imageCreateInfo {};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageCreateInfo.extent = {1, 1, 1};
+	imageCreateInfo.mipLevels = 1;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkImage image;
+	VkResult result = vkCreateImage (mainDevice.logicalDevice, &imageCreateInfo, hostAllocator, &image);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a texture image...");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements (mainDevice.logicalDevice, image, &memoryRequirements);
+
+	VkMemoryAllocateInfo memoryAllocateInfo {};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.allocationSize = memoryRequirements.size;
+	memoryAllocateInfo.memoryTypeIndex = FindMemoryTypeIndex (memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory imageMemory;
+	result = vkAllocateMemory (mainDevice.logicalDevice, &memoryAllocateInfo, hostAllocator, &imageMemory);
+	if (result != VK_SUCCESS) {
+		vkDestroyImage (mainDevice.logicalDevice, image, hostAllocator);
+		throw std::runtime_error ("Failed to allocate texture memory...");
+	}
+	vkBindImageMemory (mainDevice.logicalDevice, image, imageMemory, 0);
+
+	solidTextureImages.push_back (image);
+	solidTextureMemory.push_back (imageMemory);
+
+	std::array<uint8_t, 4> texel;
+	for (size_t i = 0; i < texel.size (); ++i) {
+		texel[i] = static_cast<uint8_t> (std::lround (glm::clamp (color[static_cast<int> (i)], 0.0f, 1.0f) * 255.0f));
+	}
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	CreateBuffer (texel.size (), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				  stagingBuffer, stagingMemory);
+
+	void* data;
+	vkMapMemory (mainDevice.logicalDevice, stagingMemory, 0, texel.size (), 0, &data);
+	std::memcpy (data, texel.data (), texel.size ());
+	vkUnmapMemory (mainDevice.logicalDevice, stagingMemory);
+
+	VkCommandBuffer commandBuffer = BeginOneTimeCommands ();
+
+		VkImageMemoryBarrier imageBarrier {};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageBarrier.srcAccessMask = 0;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = image;
+		imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferImageCopy copyRegion {};
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageExtent = {1, 1, 1};
+		vkCmdCopyBufferToImage (commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	EndOneTimeCommands (commandBuffer);
+
+	vkDestroyBuffer (mainDevice.logicalDevice, stagingBuffer, hostAllocator);
+	vkFreeMemory (mainDevice.logicalDevice, stagingMemory, hostAllocator);
+
+	VkImageView imageView = CreateImageView (image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+	solidTextureViews.push_back (imageView);
+
+	return bindlessHeap.AddTexture (imageView, bindlessSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+
+uint32_t VulkanRenderer::AddMaterial (const glm::vec4& tint)
+{
+	if (!useBindless) {
+		throw std::runtime_error ("Bindless resources need descriptor indexing support...");
+	}
+	if (materialCount == MaterialCapacity) {
+		throw std::runtime_error ("The material buffer is full...");
+	}
+
+	// a new entry, so no frame in flight reads this part of the buffer
+	VkDeviceSize offset = materialCount * materialStride;
+	std::memcpy (materialData + offset, &tint, sizeof (tint));
+	++materialCount;
+
+	return bindlessHeap.AddBuffer (materialBuffer, offset, sizeof (glm::vec4));
+}
+
+
+uint32_t VulkanRenderer::AddBindlessTexture (VkImageView imageView, VkImageLayout imageLayout)
+{
+	if (!useBindless) {
+		throw std::runtime_error ("Bindless resources need descriptor indexing support...");
+	}
+
+	return bindlessHeap.AddTexture (imageView, bindlessSampler, imageLayout);
+}
+
+
+uint32_t VulkanRenderer::AddBindlessBuffer (VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	if (!useBindless) {
+		throw std::runtime_error ("Bindless resources need descriptor indexing support...");
+	}
+
+	return bindlessHeap.AddBuffer (buffer, offset, range);
+}
+
+
+void VulkanRenderer::SetPostProcessEnabled (bool enabled, float vignetteStrength)
+{
+	if (enabled && !IsPostProcessSupported ()) {
+		throw std::runtime_error ("Post-processing needs a compute queue and RGBA8 frame images usable as storage images...");
+	}
+
+	// the last submit of a frame moves between queues, nothing may still be pending on the old one
+	WaitIdle ();
+	postProcessEnabled = enabled;
+	if (!enabled) {
+		return;
+	}
+
+	ComputePipeline& postProcess = computePipelines.front ();
+	SpecializationConstants constants = postProcess.constants;
+	constants.Set (PostProcessVignetteConstant, vignetteStrength);
+	if (constants != postProcess.constants) {
+		ComputePipeline description = postProcess;
+		description.constants = constants;
+		VkPipeline pipeline = CreateComputePipeline (description, shaderModules[description.shaderModule].module);
+
+		DestroyDeferred (postProcess.pipeline);
+		postProcess = description;
+		postProcess.pipeline = pipeline;
+	}
+}
+
+
+uint32_t VulkanRenderer::AddComputePipeline (const std::string& shaderFileName, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+											 uint32_t groupWidth, uint32_t groupHeight, const SpecializationConstants& constants)
+{
+	if (queueFamilies.computeFamily < 0) {
+		throw std::runtime_error ("Compute pipelines need a compute queue...");
+	}
+
+	const VkPhysicalDeviceLimits& limits = deviceProperties.limits;
+	if (groupWidth == 0 || groupHeight == 0 || groupWidth > limits.maxComputeWorkGroupSize[0] ||
+		groupHeight > limits.maxComputeWorkGroupSize[1] || groupWidth * groupHeight > limits.maxComputeWorkGroupInvocations)
+	{
+		throw std::runtime_error ("Compute group size is outside the device limits...");
+	}
+
+	ComputePipeline computePipeline {};
+	computePipeline.shaderModule = FindOrAddShaderModule (shaderFileName);
+	computePipeline.groupWidth = groupWidth;
+	computePipeline.groupHeight = groupHeight;
+	computePipeline.constants = constants;
+	computePipeline.constants.Set (ComputeGroupWidthConstant, groupWidth);
+	computePipeline.constants.Set (ComputeGroupHeightConstant, groupHeight);
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo {};
+	setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutCreateInfo.bindingCount = static_cast<uint32_t> (bindings.size ());
+	setLayoutCreateInfo.pBindings = bindings.data ();
+
+	VkResult result = vkCreateDescriptorSetLayout (mainDevice.logicalDevice, &setLayoutCreateInfo, hostAllocator, &computePipeline.setLayout);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a descriptor set layout...");
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &computePipeline.setLayout;
+
+	result = vkCreatePipelineLayout (mainDevice.logicalDevice, &pipelineLayoutCreateInfo, hostAllocator, &computePipeline.layout);
+	if (result != VK_SUCCESS) {
+		vkDestroyDescriptorSetLayout (mainDevice.logicalDevice, computePipeline.setLayout, hostAllocator);
+		throw std::runtime_error ("Failed to create pipeline layout...");
+	}
+
+	try {
+		computePipeline.pipeline = CreateComputePipeline (computePipeline, shaderModules[computePipeline.shaderModule].module);
+	} catch (const std::runtime_error&) {
+		vkDestroyPipelineLayout (mainDevice.logicalDevice, computePipeline.layout, hostAllocator);
+		vkDestroyDescriptorSetLayout (mainDevice.logicalDevice, computePipeline.setLayout, hostAllocator);
+		throw;
+	}
+
+	computePipelines.push_back (computePipeline);
+	return static_cast<uint32_t> (computePipelines.size () - 1);
+}
+
+
+VkDescriptorSet VulkanRenderer::AllocateComputeDescriptorSet (uint32_t pipelineIndex)
+{
+	if (pipelineIndex >= computePipelines.size ()) {
+		throw std::out_of_range ("Compute pipeline index out of range...");
+	}
+
+	VkDescriptorSetAllocateInfo setAllocateInfo {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorSetCount = 1;
+	setAllocateInfo.pSetLayouts = &computePipelines[pipelineIndex].setLayout;
+
+	// a full pool is not an error, the set goes into a fresh one
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+	if (!computeDescriptorPools.empty ()) {
+		setAllocateInfo.descriptorPool = computeDescriptorPools.back ();
+		result = vkAllocateDescriptorSets (mainDevice.logicalDevice, &setAllocateInfo, &descriptorSet);
+	}
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+		CreateComputeDescriptorPool ();
+		setAllocateInfo.descriptorPool = computeDescriptorPools.back ();
+		result = vkAllocateDescriptorSets (mainDevice.logicalDevice, &setAllocateInfo, &descriptorSet);
+	}
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate a compute descriptor set...");
+	}
+
+	return descriptorSet;
+}
+
+
+void VulkanRenderer::WriteComputeImage (VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type,
+										VkImageView imageView, VkImageLayout imageLayout, VkSampler sampler)
+{
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet descriptorWrite {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = binding;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = type;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets (mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
+}
+
+
+void VulkanRenderer::WriteComputeBuffer (VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type,
+										 VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet descriptorWrite {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = binding;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = type;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets (mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
+}
+
+
+uint32_t VulkanRenderer::AddDispatch (const ComputeDispatch& dispatch)
+{
+	if (dispatch.pipelineIndex >= computePipelines.size ()) {
+		throw std::out_of_range ("Dispatch pipeline index out of range...");
+	}
+
+	bool usedComputeSubmit = UsesComputeSubmit ();
+	computeDispatches.push_back (dispatch);
+	computeQueueDispatchCount += dispatch.queue == ComputeQueue::Compute ? 1 : 0;
+
+	// the last submit of a frame moves between queues, nothing may still be pending on the old one
+	if (UsesComputeSubmit () != usedComputeSubmit) {
+		WaitIdle ();
+	}
+
+	return static_cast<uint32_t> (computeDispatches.size () - 1);
+}
+
+
+void VulkanRenderer::ClearDispatches ()
+{
+	bool usedComputeSubmit = UsesComputeSubmit ();
+	computeDispatches.clear ();
+	computeQueueDispatchCount = 0;
+
+	if (UsesComputeSubmit () != usedComputeSubmit) {
+		WaitIdle ();
+	}
+}
+
+
+bool VulkanRenderer::ReloadShaderModule (const std::string& fileName, const std::vector<uint32_t>& code)
+{
+	auto found = std::find_if (shaderModules.begin (), shaderModules.end (), [&fileName] (const ShaderModule& shaderModule) {
+		return shaderModule.fileName == fileName;
+	});
+	if (found == shaderModules.end ()) {
+		return false;
+	}
+	uint32_t moduleIndex = static_cast<uint32_t> (found - shaderModules.begin ());
+
+	// build everything first, a module that fails to compile into a pipeline leaves the old ones running
+	VkShaderModule newModule = VK_NULL_HANDLE;
+	std::vector<VkPipeline> newPipelines (graphicsPipelines.size (), VK_NULL_HANDLE);
+	std::vector<VkPipeline> newComputePipelines (computePipelines.size (), VK_NULL_HANDLE);
+	try {
+		newModule = CreateShaderModule (code.data (), code.size () * sizeof (uint32_t));
+
+		for (size_t i = 0; i < graphicsPipelines.size (); ++i) {
+			const GraphicsPipeline& graphicsPipeline = graphicsPipelines[i];
+			if (graphicsPipeline.vertexModule != moduleIndex && graphicsPipeline.fragmentModule != moduleIndex) {
+				continue;
+			}
+
+			VkShaderModule vertexModule = graphicsPipeline.vertexModule == moduleIndex ? newModule : shaderModules[graphicsPipeline.vertexModule].module;
+			VkShaderModule fragmentModule = graphicsPipeline.fragmentModule == moduleIndex ? newModule : shaderModules[graphicsPipeline.fragmentModule].module;
+			newPipelines[i] = CreateGraphicsPipelineVariant (graphicsPipeline, vertexModule, fragmentModule);
+		}
+
+		for (size_t i = 0; i < computePipelines.size (); ++i) {
+			if (computePipelines[i].shaderModule == moduleIndex) {
+				newComputePipelines[i] = CreateComputePipeline (computePipelines[i], newModule);
+			}
+		}
+	} catch (const std::runtime_error& runtimeError) {
+		Log (LogStream::Error, "Shaders> ", fileName, ": ", runtimeError.what ());
+
+		// none of these were ever recorded, so they can go right away
+		for (const auto* pipelines : {&newPipelines, &newComputePipelines}) {
+			for (auto pipeline : *pipelines) {
+				if (pipeline != VK_NULL_HANDLE) {
+					vkDestroyPipeline (mainDevice.logicalDevice, pipeline, hostAllocator);
+				}
+			}
+		}
+		if (newModule != VK_NULL_HANDLE) {
+			vkDestroyShaderModule (mainDevice.logicalDevice, newModule, hostAllocator);
+		}
+		return false;
+	}
+
+	size_t rebuiltCount = 0;
+	for (size_t i = 0; i < graphicsPipelines.size (); ++i) {
+		if (newPipelines[i] != VK_NULL_HANDLE) {
+			DestroyDeferred (graphicsPipelines[i].pipeline);
+			graphicsPipelines[i].pipeline = newPipelines[i];
+			++rebuiltCount;
+		}
+	}
+	for (size_t i = 0; i < computePipelines.size (); ++i) {
+		if (newComputePipelines[i] != VK_NULL_HANDLE) {
+			DestroyDeferred (computePipelines[i].pipeline);
+			computePipelines[i].pipeline = newComputePipelines[i];
+			++rebuiltCount;
+		}
+	}
+	DestroyDeferred (found->module);
+	found->module = newModule;
+
+	Log (LogStream::Out, "Shaders> ", fileName, ": rebuilt ", rebuiltCount, " of ", graphicsPipelines.size () + computePipelines.size (), " pipelines");
+
+	return true;
+}
+
+
+void VulkanRenderer::SetUploadBytesPerFrame (VkDeviceSize byteCount)
+{
+	DestroyUploadBuffers ();
+
+	uploadBytesPerFrame = byteCount;
+	if (uploadBytesPerFrame == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < MaxFrameDraws; ++i) {
+		CreateBuffer (uploadBytesPerFrame, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					  uploadStagingBuffers[i], uploadStagingMemory[i]);
+		vkMapMemory (mainDevice.logicalDevice, uploadStagingMemory[i], 0, uploadBytesPerFrame, 0, &uploadStagingData[i]);
+	}
+
+	CreateBuffer (uploadBytesPerFrame, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				  uploadTargetBuffer, uploadTargetMemory);
+}
+
+
+void VulkanRenderer::DestroyUploadBuffers ()
+{
+	if (uploadBytesPerFrame == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < MaxFrameDraws; ++i) {
+		DestroyDeferred (uploadStagingBuffers[i]);
+		DestroyDeferred (uploadStagingMemory[i]);
+		uploadStagingData[i] = nullptr;
+	}
+	DestroyDeferred (uploadTargetBuffer);
+	DestroyDeferred (uploadTargetMemory);
+
+	uploadBytesPerFrame = 0;
+}
+
+
+void VulkanRenderer::SetFrameCaptureWriter (FrameCaptureWriter* newCaptureWriter)
+{
+	DestroyReadbackBuffers ();
+	captureWriter = nullptr;
+
+	if (newCaptureWriter == nullptr) {
+		return;
+	}
+	if (!headless && !swapchainTransferSource) {
+		throw std::runtime_error ("The surface does not allow copying out of swapchain images...");
+	}
+	if (swapchainImageFormat != VK_FORMAT_R8G8B8A8_UNORM && swapchainImageFormat != VK_FORMAT_R8G8B8A8_SRGB &&
+		swapchainImageFormat != VK_FORMAT_B8G8R8A8_UNORM && swapchainImageFormat != VK_FORMAT_B8G8R8A8_SRGB)
+	{
+		throw std::runtime_error ("Frame capture needs an 8 bit RGBA or BGRA swapchain...");
+	}
+
+	captureWriter = newCaptureWriter;
+	captureFrameNumber = 0;
+	droppedCaptureCount = 0;
+	CreateReadbackBuffers ();
+}
+
+
+void VulkanRenderer::CreateReadbackBuffers ()
+{
+	VkDeviceSize byteCount = static_cast<VkDeviceSize> (swapchainExtent.width) * swapchainExtent.height * 4;
+
+	// the writer reads every byte on the CPU, cached memory makes that a lot cheaper where it exists
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+		VkMemoryPropertyFlags cached = properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		if ((memoryProperties.memoryTypes[i].propertyFlags & cached) == cached) {
+			properties = cached;
+			break;
+		}
+	}
+
+	for (auto& readbackSlot : readbackSlots) {
+		CreateBuffer (byteCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties, readbackSlot.buffer, readbackSlot.memory);
+
+		void* data;
+		vkMapMemory (mainDevice.logicalDevice, readbackSlot.memory, 0, byteCount, 0, &data);
+		readbackSlot.data = static_cast<uint8_t*> (data);
+		readbackSlot.inUse = false;
+	}
+}
+
+
+void VulkanRenderer::DestroyReadbackBuffers ()
+{
+	if (captureWriter == nullptr) {
+		return;
+	}
+
+	// hand over what has completed and let the writer finish reading it; frames still in flight
+	// lose their capture, the copy they record lands in buffers that are only freed after them
+	PollCompletedFrames ();
+	captureWriter->WaitUntilIdle ();
+	frameReadbackSlots.fill (-1);
+
+	for (auto& readbackSlot : readbackSlots) {
+		DestroyDeferred (readbackSlot.buffer);
+		DestroyDeferred (readbackSlot.memory);
+		readbackSlot.buffer = VK_NULL_HANDLE;
+		readbackSlot.memory = VK_NULL_HANDLE;
+		readbackSlot.data = nullptr;
+		readbackSlot.inUse = false;
+	}
+}
+
+
+int VulkanRenderer::AcquireReadbackSlot ()
+{
+	uint64_t frameNumber = captureFrameNumber++;
+
+	for (size_t i = 0; i < readbackSlots.size (); ++i) {
+		if (!readbackSlots[i].inUse.load (std::memory_order_acquire)) {
+			readbackSlots[i].inUse.store (true, std::memory_order_relaxed);
+			readbackSlots[i].frameNumber = frameNumber;
+			return static_cast<int> (i);
+		}
+	}
+
+	// never wait for the writer, a missing frame number in the output shows the drop
+	++droppedCaptureCount;
+	return -1;
+}
+
+
+void VulkanRenderer::Resize (uint32_t width, uint32_t height)
+{
+	DestroyReadbackBuffers ();
+
+	// the old targets stay alive until every frame that rendered into them has completed
+	for (auto framebuffer : swapchainFrameBuffers) {
+		DestroyDeferred (framebuffer);
+	}
+	for (const auto& image : swapchainImages) {
+		DestroyDeferred (image.imageView);
+		if (headless) {
+			DestroyDeferred (image.image);
+		}
+	}
+	for (auto memory : offscreenImageMemory) {
+		DestroyDeferred (memory);
+	}
+	swapchainFrameBuffers.clear ();
+	swapchainImages.clear ();
+	offscreenImageMemory.clear ();
+
+	if (headless) {
+		headlessExtent = {width, height};
+		CreateOffscreenTargets ();
+	} else {
+		VkSwapchainKHR oldSwapchain = swapchain;
+		CreateSwapchain (oldSwapchain);
+		DestroyDeferred (oldSwapchain);
+	}
+
+	CreateFrameBuffers ();
+	CreatePostProcessDescriptors ();
+
+	// the ring is sized for the old extent
+	if (captureWriter != nullptr) {
+		CreateReadbackBuffers ();
+	}
+}
+
+
+void VulkanRenderer::WaitIdle ()
+{
+	vkDeviceWaitIdle (mainDevice.logicalDevice);
+	PollCompletedFrames ();
+	deletionQueue.Collect (GetCompletedSerial ());
+}
+
+
+void VulkanRenderer::CaptureFrame (Image& image)
+{
+	if (!headless) {
+		throw std::runtime_error ("Blocking frame capture needs a headless renderer...");
+	}
+	if (lastSubmittedSerial == 0) {
+		throw std::runtime_error ("No frame has been drawn yet...");
+	}
+
+	WaitIdle ();
+
+	uint32_t imageIndex = static_cast<uint32_t> ((currentFrame + MaxFrameDraws - 1) % MaxFrameDraws);
+	VkDeviceSize byteCount = static_cast<VkDeviceSize> (swapchainExtent.width) * swapchainExtent.height * 4;
+
+	VkBuffer readbackBuffer;
+	VkDeviceMemory readbackMemory;
+	CreateBuffer (byteCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				  readbackBuffer, readbackMemory);
+
+	VkCommandBuffer commandBuffer = BeginOneTimeCommands ();
+
+		VkBufferImageCopy copyRegion {};
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageExtent = {swapchainExtent.width, swapchainExtent.height, 1};
+		vkCmdCopyImageToBuffer (commandBuffer, swapchainImages[imageIndex].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+								readbackBuffer, 1, &copyRegion);
+
+		VkBufferMemoryBarrier hostBarrier {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.buffer = readbackBuffer;
+		hostBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+							  0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+	EndOneTimeCommands (commandBuffer);
+
+	image.width = swapchainExtent.width;
+	image.height = swapchainExtent.height;
+	image.pixels.resize (static_cast<size_t> (byteCount));
+
+	void* data;
+	vkMapMemory (mainDevice.logicalDevice, readbackMemory, 0, byteCount, 0, &data);
+	std::memcpy (image.pixels.data (), data, image.pixels.size ());
+	vkUnmapMemory (mainDevice.logicalDevice, readbackMemory);
+
+	vkDestroyBuffer (mainDevice.logicalDevice, readbackBuffer, hostAllocator);
+	vkFreeMemory (mainDevice.logicalDevice, readbackMemory, hostAllocator);
+}
+
+
+VkCommandBuffer VulkanRenderer::BeginOneTimeCommands ()
+{
+	VkCommandBufferAllocateInfo commandBufferAllocateInfo {};
+	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferAllocateInfo.commandPool = graphicsCommandPool;
+	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferAllocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	VkResult result = vkAllocateCommandBuffers (mainDevice.logicalDevice, &commandBufferAllocateInfo, &commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate command buffers...");
+	}
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	result = vkBeginCommandBuffer (commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to start recording a command buffer...");
+	}
+
+	return commandBuffer;
+}
+
+
+void VulkanRenderer::EndOneTimeCommands (VkCommandBuffer commandBuffer)
+{
+	VkResult result = vkEndCommandBuffer (commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to stop recording a command buffer...");
+	}
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	result = vkQueueSubmit (graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to submit command buffer to queue...");
+	}
+
+	// one time commands are for setup and tooling paths, never the frame loop
+	vkQueueWaitIdle (graphicsQueue);
+	vkFreeCommandBuffers (mainDevice.logicalDevice, graphicsCommandPool, 1, &commandBuffer);
+}
+
+
 void VulkanRenderer::CleanUp ()
+{
+	// a failed Init gets here too, every handle past the step that failed is still null
+	if (mainDevice.logicalDevice != VK_NULL_HANDLE) {
+		DestroyDeviceObjects ();
+		vkDestroyDevice (mainDevice.logicalDevice, hostAllocator);
+		mainDevice.logicalDevice = VK_NULL_HANDLE;
+	}
+	if (surface != VK_NULL_HANDLE) {
+		vkDestroySurfaceKHR (instance, surface, hostAllocator);
+		surface = VK_NULL_HANDLE;
+	}
+	if (instance != VK_NULL_HANDLE) {
+		vkDestroyInstance (instance, hostAllocator);
+		instance = VK_NULL_HANDLE;
+	}
+}
+
+
+void VulkanRenderer::DestroyDeviceObjects ()
 {
 	vkDeviceWaitIdle (mainDevice.logicalDevice);
 
-	for (size_t i = 0; i < MaxFrameDraws; ++i) {
-		vkDestroySemaphore (mainDevice.logicalDevice, rendersFinished[i], nullptr);
-		vkDestroySemaphore (mainDevice.logicalDevice, imagesAvailable[i], nullptr);
-		vkDestroyFence (mainDevice.logicalDevice, drawFences[i], nullptr);
+	DestroyReadbackBuffers ();
+	captureWriter = nullptr;
+	deletionQueue.Flush ();
+
+	for (auto semaphore : rendersFinished) {
+		vkDestroySemaphore (mainDevice.logicalDevice, semaphore, hostAllocator);
+	}
+	for (auto semaphore : imagesAvailable) {
+		vkDestroySemaphore (mainDevice.logicalDevice, semaphore, hostAllocator);
 	}
+	for (auto semaphore : graphicsFinished) {
+		vkDestroySemaphore (mainDevice.logicalDevice, semaphore, hostAllocator);
+	}
+	for (auto fence : drawFences) {
+		vkDestroyFence (mainDevice.logicalDevice, fence, hostAllocator);
+	}
+	graphicsTimeline.Destroy ();
+	computeTimeline.Destroy ();
 
-	vkDestroyCommandPool (mainDevice.logicalDevice, graphicsCommandPool, nullptr);
+	for (size_t i = 0; uploadBytesPerFrame != 0 && i < MaxFrameDraws; ++i) {
+		vkDestroyBuffer (mainDevice.logicalDevice, uploadStagingBuffers[i], hostAllocator);
+		vkFreeMemory (mainDevice.logicalDevice, uploadStagingMemory[i], hostAllocator);
+	}
+	if (uploadBytesPerFrame != 0) {
+		vkDestroyBuffer (mainDevice.logicalDevice, uploadTargetBuffer, hostAllocator);
+		vkFreeMemory (mainDevice.logicalDevice, uploadTargetMemory, hostAllocator);
+	}
+
+	vkDestroyCommandPool (mainDevice.logicalDevice, graphicsCommandPool, hostAllocator);
+	if (computeCommandPool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool (mainDevice.logicalDevice, computeCommandPool, hostAllocator);
+	}
 	for (auto framebuffer : swapchainFrameBuffers) {
-		vkDestroyFramebuffer (mainDevice.logicalDevice, framebuffer, nullptr);
+		vkDestroyFramebuffer (mainDevice.logicalDevice, framebuffer, hostAllocator);
+	}
+	for (const auto& graphicsPipeline : graphicsPipelines) {
+		vkDestroyPipeline (mainDevice.logicalDevice, graphicsPipeline.pipeline, hostAllocator);
+	}
+	for (const auto& computePipeline : computePipelines) {
+		vkDestroyPipeline (mainDevice.logicalDevice, computePipeline.pipeline, hostAllocator);
+		vkDestroyPipelineLayout (mainDevice.logicalDevice, computePipeline.layout, hostAllocator);
+		vkDestroyDescriptorSetLayout (mainDevice.logicalDevice, computePipeline.setLayout, hostAllocator);
 	}
-	vkDestroyPipeline (mainDevice.logicalDevice, graphicsPipeline, nullptr);
-	vkDestroyPipelineLayout (mainDevice.logicalDevice, pipelineLayout, nullptr);
-	vkDestroyRenderPass (mainDevice.logicalDevice, renderPass, nullptr);
+	for (auto descriptorPool : computeDescriptorPools) {
+		vkDestroyDescriptorPool (mainDevice.logicalDevice, descriptorPool, hostAllocator);
+	}
+	for (const auto& shaderModule : shaderModules) {
+		vkDestroyShaderModule (mainDevice.logicalDevice, shaderModule.module, hostAllocator);
+	}
+	if (postProcessDescriptorPool != VK_NULL_HANDLE) {
+		vkDestroyDescriptorPool (mainDevice.logicalDevice, postProcessDescriptorPool, hostAllocator);
+	}
+	vkDestroyPipelineLayout (mainDevice.logicalDevice, pipelineLayout, hostAllocator);
+	if (useBindless) {
+		for (size_t i = 0; i < solidTextureImages.size (); ++i) {
+			vkDestroyImageView (mainDevice.logicalDevice, solidTextureViews[i], hostAllocator);
+			vkDestroyImage (mainDevice.logicalDevice, solidTextureImages[i], hostAllocator);
+			vkFreeMemory (mainDevice.logicalDevice, solidTextureMemory[i], hostAllocator);
+		}
+		vkDestroyBuffer (mainDevice.logicalDevice, materialBuffer, hostAllocator);
+		vkFreeMemory (mainDevice.logicalDevice, materialMemory, hostAllocator);
+		vkDestroySampler (mainDevice.logicalDevice, bindlessSampler, hostAllocator);
+		bindlessHeap.Destroy ();
+	}
+	vkDestroyRenderPass (mainDevice.logicalDevice, renderPass, hostAllocator);
 	for (auto image : swapchainImages) {
-		vkDestroyImageView (mainDevice.logicalDevice, image.imageView, nullptr);
+		vkDestroyImageView (mainDevice.logicalDevice, image.imageView, hostAllocator);
+		if (headless) {
+			vkDestroyImage (mainDevice.logicalDevice, image.image, hostAllocator);
+		}
+	}
+	for (auto memory : offscreenImageMemory) {
+		vkFreeMemory (mainDevice.logicalDevice, memory, hostAllocator);
+	}
+	if (!headless) {
+		vkDestroySwapchainKHR (mainDevice.logicalDevice, swapchain, hostAllocator);
 	}
-	vkDestroySwapchainKHR (mainDevice.logicalDevice, swapchain, nullptr);
-	vkDestroySurfaceKHR (instance, surface, nullptr);
-	vkDestroyDevice (mainDevice.logicalDevice, nullptr);
-	vkDestroyInstance (instance, nullptr);
 }
 
 
@@ -73,7 +999,11 @@ void VulkanRenderer::CreateInstance ()
 	applicationInfo.applicationVersion = VK_MAKE_VERSION (1, 0, 0);
 	applicationInfo.pEngineName = "No engine";
 	applicationInfo.engineVersion = VK_MAKE_VERSION (1, 0, 0);
-	applicationInfo.apiVersion = VK_API_VERSION_1_0;
+	// timeline semaphores need a 1.2 instance, anything older keeps the fence path
+	uint32_t loaderVersion = VK_API_VERSION_1_0;
+	vkEnumerateInstanceVersion (&loaderVersion);
+	instanceApiVersion = loaderVersion >= VK_API_VERSION_1_2 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0;
+	applicationInfo.apiVersion = instanceApiVersion;
 
 	VkInstanceCreateInfo createInfo {};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -81,12 +1011,15 @@ void VulkanRenderer::CreateInstance ()
 
 	std::vector<const char*> instanceExtensions;
 
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
+	// headless rendering needs no window system extensions, and no glfwInit
+	if (!headless) {
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions;
 
-	glfwExtensions = glfwGetRequiredInstanceExtensions (&glfwExtensionCount);
-	for (size_t i = 0; i < glfwExtensionCount; ++i) {
-		instanceExtensions.push_back (glfwExtensions [i]);
+		glfwExtensions = glfwGetRequiredInstanceExtensions (&glfwExtensionCount);
+		for (size_t i = 0; i < glfwExtensionCount; ++i) {
+			instanceExtensions.push_back (glfwExtensions [i]);
+		}
 	}
 
 	if (!CheckInstanceExtensionSupport (&instanceExtensions)) {
@@ -99,7 +1032,7 @@ void VulkanRenderer::CreateInstance ()
 	createInfo.enabledLayerCount = 0;
 	createInfo.ppEnabledLayerNames = nullptr;
 
-	VkResult result = vkCreateInstance (&createInfo, nullptr, &instance);
+	VkResult result = vkCreateInstance (&createInfo, hostAllocator, &instance);
 
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a vulkan instance...");
@@ -145,33 +1078,85 @@ void VulkanRenderer::GetPhysicalDevice ()
 	std::vector<VkPhysicalDevice> deviceList (deviceCount);
 	vkEnumeratePhysicalDevices (instance, &deviceCount, deviceList.data ());
 
-	for (const auto& device : deviceList) {
-		if (CheckDeviceSuitable (device)) {
-			mainDevice.physicalDevice = device;
-			break;
+	if (deviceOverride.empty ()) {
+		const char* deviceOverrideVariable = std::getenv ("VULKAN_DEVICE");
+		deviceOverride = deviceOverrideVariable != nullptr ? deviceOverrideVariable : "";
+	}
+
+	std::vector<PhysicalDeviceInfo> candidates;
+	std::vector<int64_t> scores;
+	int selected = -1;
+	bool overridden = false;
+
+	for (uint32_t i = 0; i < deviceCount; ++i) {
+		candidates.push_back (GetPhysicalDeviceInfo (deviceList[i], i, instanceApiVersion));
+		// unsuitable devices keep a negative score, so they are reported but never picked
+		scores.push_back (CheckDeviceSuitable (deviceList[i]) ? ScorePhysicalDevice (candidates.back ()) : -1);
+
+		if (MatchesDeviceOverride (candidates.back (), deviceOverride)) {
+			if (scores.back () < 0) {
+				throw std::runtime_error ("Device " + DescribePhysicalDevice (candidates.back ()) + " from the device override cannot run the renderer...");
+			}
+			selected = static_cast<int> (i);
+			overridden = true;
+		} else if (!overridden && scores.back () >= 0 && (selected < 0 || scores.back () > scores[selected])) {
+			selected = static_cast<int> (i);
+		}
+	}
+
+	if (!deviceOverride.empty () && !overridden) {
+		throw std::runtime_error ("No device matches the device override " + deviceOverride + "...");
+	}
+	if (selected < 0) {
+		throw std::runtime_error ("Cannot find a GPU suitable for the renderer...");
+	}
+
+	for (uint32_t i = 0; i < deviceCount; ++i) {
+		std::clog << "Device> " << DescribePhysicalDevice (candidates[i]);
+		if (scores[i] < 0) {
+			std::clog << " unsuitable";
+		} else {
+			std::clog << " score " << scores[i];
 		}
+		if (static_cast<int> (i) == selected) {
+			std::clog << (overridden ? " <- selected by override" : " <- selected");
+		}
+		std::clog << std::endl;
 	}
+
+	mainDevice.physicalDevice = deviceList[selected];
+	CacheDeviceData ();
 }
 
 
-bool VulkanRenderer::CheckDeviceSuitable (VkPhysicalDevice device)
+void VulkanRenderer::CacheDeviceData ()
 {
-	/*
-	VkPhysicalDeviceProperties deviceProperties;
-	vkGetPhysicalDeviceProperties (device, &deviceProperties);
+	queueFamilies = GetQueueFamilies (mainDevice.physicalDevice);
+	vkGetPhysicalDeviceProperties (mainDevice.physicalDevice, &deviceProperties);
+	vkGetPhysicalDeviceMemoryProperties (mainDevice.physicalDevice, &memoryProperties);
+
+	// formats and present modes belong to the surface, the capabilities are re-read per swapchain
+	if (!headless) {
+		swapchainDetails = GetSwapchainDetails (mainDevice.physicalDevice);
+	}
+}
 
-	VkPhysicalDeviceFeatures deviceFeatures;
-	vkGetPhysicalDeviceFeatures (device, &deviceFeatures);
-	*/
 
+bool VulkanRenderer::CheckDeviceSuitable (VkPhysicalDevice device)
+{
+	// only hard requirements here, preferences between suitable devices are ScorePhysicalDevice's job
 	QueueFamilyIndices indices = GetQueueFamilies (device);
 
+	if (headless) {
+		return indices.IsValid ();
+	}
+
 	bool extensionSupported = CheckDeviceExtensionSupport (device);
 
 	bool swapchainValid = false;
 	if (extensionSupported) {
-		SwapchainDetails swapchainDetails = GetSwapchainDetails (device);
-		swapchainValid = !swapchainDetails.formats.empty () && !swapchainDetails.presentationModes.empty ();
+		SwapchainDetails candidateDetails = GetSwapchainDetails (device);
+		swapchainValid = !candidateDetails.formats.empty () && !candidateDetails.presentationModes.empty ();
 	}
 
 	return indices.IsValid () && extensionSupported && swapchainValid ;
@@ -190,40 +1175,59 @@ QueueFamilyIndices VulkanRenderer::GetQueueFamilies (VkPhysicalDevice device )
 
 	int deviceLocation = 0;
 	for (const auto& queueFamily : queueFamilyList) {
-		if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
-			indices.graphicsFamily = deviceLocation;
+		if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+			!(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && indices.computeFamily < 0)
+		{
+			indices.computeFamily = deviceLocation;
 		}
 
-		VkBool32 presentationSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR (device, deviceLocation, surface, &presentationSupport);
-		if (queueFamily.queueCount > 0 && presentationSupport) {
-			indices.presentationFamily = deviceLocation;
-		}
+		if (!indices.IsValid ()) {
+			if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+				indices.graphicsFamily = deviceLocation;
+			}
 
-		if (indices.IsValid ()) {
-			break;
+			if (headless) {
+				// nothing is presented, the graphics queue stands in so the indices stay valid
+				indices.presentationFamily = indices.graphicsFamily;
+			} else {
+				VkBool32 presentationSupport = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR (device, deviceLocation, surface, &presentationSupport);
+				if (queueFamily.queueCount > 0 && presentationSupport) {
+					indices.presentationFamily = deviceLocation;
+				}
+			}
 		}
 
 		++deviceLocation;
 	}
 
+	// without a separate compute engine compute work shares the graphics queue
+	if (indices.computeFamily < 0 && indices.graphicsFamily >= 0 &&
+		(queueFamilyList[indices.graphicsFamily].queueFlags & VK_QUEUE_COMPUTE_BIT))
+	{
+		indices.computeFamily = indices.graphicsFamily;
+	}
+
 	return indices;
 }
 
 
 void VulkanRenderer::CreateLogicalDevice ()
 {
-	QueueFamilyIndices indices = GetQueueFamilies (mainDevice.physicalDevice);
+	const QueueFamilyIndices& indices = queueFamilies;
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<int> queueFamilyIndices {indices.graphicsFamily, indices.graphicsFamily};
+	std::set<int> queueFamilyIndices {indices.graphicsFamily, indices.presentationFamily};
+	if (indices.computeFamily >= 0) {
+		queueFamilyIndices.insert (indices.computeFamily);
+	}
+	float priority = 1.0f;
 
 	for (int queueFamilyIndex : queueFamilyIndices) {
 		VkDeviceQueueCreateInfo queueCreateInfo {};
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
 		queueCreateInfo.queueCount = 1;
-		float priority = 1.0f;
 		queueCreateInfo.pQueuePriorities = &priority;
 
 		queueCreateInfos.emplace_back (queueCreateInfo);
@@ -233,19 +1237,116 @@ void VulkanRenderer::CreateLogicalDevice ()
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t> (queueCreateInfos.size ());
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t> (deviceExtensions.size ());
-	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data ();
+	deviceCreateInfo.enabledExtensionCount = headless ? 0 : static_cast<uint32_t> (deviceExtensions.size ());
+	deviceCreateInfo.ppEnabledExtensionNames = headless ? nullptr : deviceExtensions.data ();
 
 	VkPhysicalDeviceFeatures deviceFeatures {};
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-	VkResult result = vkCreateDevice (mainDevice.physicalDevice, &deviceCreateInfo, nullptr, &mainDevice.logicalDevice);
+	const char* timelineSetting = std::getenv ("VULKAN_TIMELINE_SYNC");
+	bool timelineRequested = timelineSetting == nullptr || std::string (timelineSetting) != "0";
+	useTimelineSync = timelineRequested && CheckTimelineSupport (mainDevice.physicalDevice);
+
+	const char* bindlessSetting = std::getenv ("VULKAN_BINDLESS");
+	bool bindlessRequested = bindlessSetting == nullptr || std::string (bindlessSetting) != "0";
+	useBindless = bindlessRequested && CheckBindlessSupport (mainDevice.physicalDevice);
+
+	VkPhysicalDeviceVulkan12Features vulkan12Features {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	if (useTimelineSync) {
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+	}
+	if (useBindless) {
+		vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+		vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		// the heap arrays are indexed by push constants, dynamically uniform but not constant
+		deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+	}
+	if (useTimelineSync || useBindless) {
+		deviceCreateInfo.pNext = &vulkan12Features;
+	}
+
+	VkResult result = vkCreateDevice (mainDevice.physicalDevice, &deviceCreateInfo, hostAllocator, &mainDevice.logicalDevice);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a logical device...");
 	}
 
+	deletionQueue.Init (mainDevice.logicalDevice, hostAllocator);
+
 	vkGetDeviceQueue (mainDevice.logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
 	vkGetDeviceQueue (mainDevice.logicalDevice, indices.presentationFamily, 0, &presentationQueue);
+	if (indices.computeFamily >= 0) {
+		vkGetDeviceQueue (mainDevice.logicalDevice, indices.computeFamily, 0, &computeQueue);
+	}
+}
+
+
+bool VulkanRenderer::GetVulkan12Features (VkPhysicalDevice device, VkPhysicalDeviceVulkan12Features& vulkan12Features)
+{
+	vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	if (instanceApiVersion < VK_API_VERSION_1_2) {
+		return false;
+	}
+
+	VkPhysicalDeviceProperties candidateProperties;
+	vkGetPhysicalDeviceProperties (device, &candidateProperties);
+	if (candidateProperties.apiVersion < VK_API_VERSION_1_2) {
+		return false;
+	}
+
+	VkPhysicalDeviceFeatures2 deviceFeatures {};
+	deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures.pNext = &vulkan12Features;
+	vkGetPhysicalDeviceFeatures2 (device, &deviceFeatures);
+
+	return true;
+}
+
+
+bool VulkanRenderer::CheckTimelineSupport (VkPhysicalDevice device)
+{
+	VkPhysicalDeviceVulkan12Features vulkan12Features;
+	return GetVulkan12Features (device, vulkan12Features) && vulkan12Features.timelineSemaphore == VK_TRUE;
+}
+
+
+bool VulkanRenderer::CheckBindlessSupport (VkPhysicalDevice device)
+{
+	VkPhysicalDeviceVulkan12Features vulkan12Features;
+	if (!GetVulkan12Features (device, vulkan12Features)) {
+		return false;
+	}
+
+	VkPhysicalDeviceFeatures coreFeatures;
+	vkGetPhysicalDeviceFeatures (device, &coreFeatures);
+
+	return coreFeatures.shaderSampledImageArrayDynamicIndexing == VK_TRUE &&
+		   coreFeatures.shaderStorageBufferArrayDynamicIndexing == VK_TRUE &&
+		   vulkan12Features.runtimeDescriptorArray == VK_TRUE &&
+		   vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE &&
+		   vulkan12Features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+		   vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+		   vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE;
+}
+
+
+bool VulkanRenderer::CheckStorageSupport (VkFormat format)
+{
+	// postprocess.comp declares its image rgba8, the view format has to match that
+	if (format != VK_FORMAT_R8G8B8A8_UNORM) {
+		return false;
+	}
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties (mainDevice.physicalDevice, format, &formatProperties);
+
+	return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
 }
 
 
@@ -281,7 +1382,7 @@ bool VulkanRenderer::CheckDeviceExtensionSupport (VkPhysicalDevice device)
 
 void VulkanRenderer::CreateSurface ()
 {
-	VkResult result = glfwCreateWindowSurface (instance, window, nullptr, &surface);
+	VkResult result = glfwCreateWindowSurface (instance, window, hostAllocator, &surface);
 
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a surface...");
@@ -343,9 +1444,9 @@ SwapchainDetails VulkanRenderer::GetSwapchainDetails (VkPhysicalDevice device)
 }
 
 
-void VulkanRenderer::CreateSwapchain ()
+void VulkanRenderer::CreateSwapchain (VkSwapchainKHR oldSwapchain)
 {
-	SwapchainDetails swapchainDetails = GetSwapchainDetails (mainDevice.physicalDevice);
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR (mainDevice.physicalDevice, surface, &swapchainDetails.surfaceCapabilities);
 
 	VkSurfaceFormatKHR surfaceFormat = ChooseBestSurfaceFormat (swapchainDetails.formats);
 	VkPresentModeKHR presentMode = ChooseBestPresentationMode (swapchainDetails.presentationModes);
@@ -369,30 +1470,43 @@ void VulkanRenderer::CreateSwapchain ()
 	swapchainCreateInfo.minImageCount = imageCount;
 	swapchainCreateInfo.imageArrayLayers = 1;
 	swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	// lets frame capture copy straight out of the presented image
+	swapchainTransferSource = (swapchainDetails.surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+	if (swapchainTransferSource) {
+		swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+	// and post-processing write to it
+	swapchainStorage = (swapchainDetails.surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT) != 0 &&
+					   CheckStorageSupport (surfaceFormat.format);
+	if (swapchainStorage) {
+		swapchainCreateInfo.imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	}
 	swapchainCreateInfo.preTransform = swapchainDetails.surfaceCapabilities.currentTransform;
 	swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	swapchainCreateInfo.clipped = VK_TRUE;
 
-	QueueFamilyIndices indices = GetQueueFamilies (mainDevice.physicalDevice);
+	const QueueFamilyIndices& indices = queueFamilies;
 
-	if (indices.graphicsFamily != indices.presentationFamily) {
-		uint32_t queueFamilyIndices[] = {
-				(uint32_t) indices.graphicsFamily,
-				(uint32_t) indices.presentationFamily
-		};
+	// post-processing writes the images from the compute family
+	std::set<uint32_t> familySet {(uint32_t) indices.graphicsFamily, (uint32_t) indices.presentationFamily};
+	if (swapchainStorage && indices.computeFamily >= 0) {
+		familySet.insert ((uint32_t) indices.computeFamily);
+	}
+	std::vector<uint32_t> queueFamilyIndices (familySet.begin (), familySet.end ());
 
+	if (queueFamilyIndices.size () > 1) {
 		swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-		swapchainCreateInfo.queueFamilyIndexCount = 2;
-		swapchainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
+		swapchainCreateInfo.queueFamilyIndexCount = static_cast<uint32_t> (queueFamilyIndices.size ());
+		swapchainCreateInfo.pQueueFamilyIndices = queueFamilyIndices.data ();
 	} else {
 		swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		swapchainCreateInfo.queueFamilyIndexCount = 0;
 		swapchainCreateInfo.pQueueFamilyIndices = nullptr;
 	}
 
-	swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+	swapchainCreateInfo.oldSwapchain = oldSwapchain;
 
-	VkResult result = vkCreateSwapchainKHR (mainDevice.logicalDevice, &swapchainCreateInfo, nullptr, &swapchain);
+	VkResult result = vkCreateSwapchainKHR (mainDevice.logicalDevice, &swapchainCreateInfo, hostAllocator, &swapchain);
 
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a swapchain...");
@@ -416,6 +1530,109 @@ void VulkanRenderer::CreateSwapchain ()
 }
 
 
+void VulkanRenderer::CreateOffscreenTargets ()
+{
+	// one target per frame in flight, so a frame never renders over one still being read
+	swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	swapchainExtent = headlessExtent;
+	swapchainStorage = CheckStorageSupport (swapchainImageFormat);
+
+	// shared with the compute family when it is a different one, post-processing writes them there
+	const QueueFamilyIndices& indices = queueFamilies;
+	std::array<uint32_t, 2> queueFamilyIndices = {(uint32_t) indices.graphicsFamily, (uint32_t) indices.computeFamily};
+	bool sharedWithCompute = swapchainStorage && indices.computeFamily >= 0 && indices.computeFamily != indices.graphicsFamily;
+
+	for (size_t i = 0; i < MaxFrameDraws; ++i) {
+		VkImageCreateInfo imageCreateInfo {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.format = swapchainImageFormat;
+		imageCreateInfo.extent = {swapchainExtent.width, swapchainExtent.height, 1};
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		if (swapchainStorage) {
+			imageCreateInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+		}
+		imageCreateInfo.sharingMode = sharedWithCompute ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+		imageCreateInfo.queueFamilyIndexCount = sharedWithCompute ? 2 : 0;
+		imageCreateInfo.pQueueFamilyIndices = sharedWithCompute ? queueFamilyIndices.data () : nullptr;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		SwapchainImage offscreenImage {};
+		VkResult result = vkCreateImage (mainDevice.logicalDevice, &imageCreateInfo, hostAllocator, &offscreenImage.image);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error ("Failed to create an offscreen image...");
+		}
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements (mainDevice.logicalDevice, offscreenImage.image, &memoryRequirements);
+
+		VkMemoryAllocateInfo memoryAllocateInfo {};
+		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocateInfo.allocationSize = memoryRequirements.size;
+		memoryAllocateInfo.memoryTypeIndex = FindMemoryTypeIndex (memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkDeviceMemory imageMemory;
+		result = vkAllocateMemory (mainDevice.logicalDevice, &memoryAllocateInfo, hostAllocator, &imageMemory);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error ("Failed to allocate offscreen image memory...");
+		}
+		vkBindImageMemory (mainDevice.logicalDevice, offscreenImage.image, imageMemory, 0);
+
+		offscreenImage.imageView = CreateImageView (offscreenImage.image, swapchainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		swapchainImages.emplace_back (offscreenImage);
+		offscreenImageMemory.push_back (imageMemory);
+	}
+}
+
+
+uint32_t VulkanRenderer::FindMemoryTypeIndex (uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+		if ((allowedTypes & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error ("Failed to find a suitable memory type...");
+}
+
+
+void VulkanRenderer::CreateBuffer (VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+								   VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkBufferCreateInfo bufferCreateInfo {};
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.size = size;
+	bufferCreateInfo.usage = usage;
+	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkResult result = vkCreateBuffer (mainDevice.logicalDevice, &bufferCreateInfo, hostAllocator, &buffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a buffer...");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements (mainDevice.logicalDevice, buffer, &memoryRequirements);
+
+	VkMemoryAllocateInfo memoryAllocateInfo {};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.allocationSize = memoryRequirements.size;
+	memoryAllocateInfo.memoryTypeIndex = FindMemoryTypeIndex (memoryRequirements.memoryTypeBits, properties);
+
+	result = vkAllocateMemory (mainDevice.logicalDevice, &memoryAllocateInfo, hostAllocator, &memory);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate buffer memory...");
+	}
+
+	vkBindBufferMemory (mainDevice.logicalDevice, buffer, memory, 0);
+}
+
+
 VkExtent2D VulkanRenderer::ChooseSwapExtent (const VkSurfaceCapabilitiesKHR& surfaceCapabilities)
 {
 	if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max ()) {
@@ -437,54 +1654,161 @@ VkExtent2D VulkanRenderer::ChooseSwapExtent (const VkSurfaceCapabilitiesKHR& sur
 }
 
 
-VkImageView VulkanRenderer::CreateImageView (VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+VkImageView VulkanRenderer::CreateImageView (VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+{
+	VkImageViewCreateInfo viewCreateInfo {};
+	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCreateInfo.image = image;
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewCreateInfo.format = format;
+	viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+	viewCreateInfo.subresourceRange.aspectMask = aspectFlags;
+	viewCreateInfo.subresourceRange.baseMipLevel = 0;
+	viewCreateInfo.subresourceRange.levelCount = 1;
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	viewCreateInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	VkResult result = vkCreateImageView (mainDevice.logicalDevice, &viewCreateInfo, hostAllocator, &imageView);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create an image view..");
+	}
+
+	return imageView;
+}
+
+
+void VulkanRenderer::CreateBindlessHeap ()
+{
+	if (!useBindless) {
+		return;
+	}
+
+	VkPhysicalDeviceVulkan12Properties vulkan12Properties {};
+	vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+	VkPhysicalDeviceProperties2 deviceProperties2 {};
+	deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	deviceProperties2.pNext = &vulkan12Properties;
+	vkGetPhysicalDeviceProperties2 (mainDevice.physicalDevice, &deviceProperties2);
+
+	// the set is visible to every stage, so the per stage limits apply to all of it
+	uint32_t textureCapacity = std::min ({4096u,
+										  vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+										  vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+										  vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+										  vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers});
+	uint32_t bufferCapacity = std::min ({4096u,
+										 vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+										 vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers});
+	uint32_t resourceLimit = vulkan12Properties.maxPerStageUpdateAfterBindResources;
+	if (textureCapacity + bufferCapacity > resourceLimit) {
+		textureCapacity = std::min (textureCapacity, resourceLimit / 2);
+		bufferCapacity = std::min (bufferCapacity, resourceLimit - textureCapacity);
+	}
+
+	bindlessHeap.Create (mainDevice.logicalDevice, hostAllocator, textureCapacity, bufferCapacity);
+
+	VkSamplerCreateInfo samplerCreateInfo {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	VkResult result = vkCreateSampler (mainDevice.logicalDevice, &samplerCreateInfo, hostAllocator, &bindlessSampler);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a sampler...");
+	}
+
+	VkDeviceSize alignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+	materialStride = (sizeof (glm::vec4) + alignment - 1) / alignment * alignment;
+	materialCount = 0;
+
+	CreateBuffer (materialStride * MaterialCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				  materialBuffer, materialMemory);
+
+	void* data;
+	vkMapMemory (mainDevice.logicalDevice, materialMemory, 0, VK_WHOLE_SIZE, 0, &data);
+	materialData = static_cast<uint8_t*> (data);
+}
+
+
+void VulkanRenderer::CreateGraphicsPipeline ()
 {
-	VkImageViewCreateInfo viewCreateInfo {};
-	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	viewCreateInfo.image = image;
-	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewCreateInfo.format = format;
-	viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-	viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-	viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-	viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	for (const char* fileName : {"vert.spv", "frag.spv"}) {
+		const EmbeddedShader* shader = FindEmbeddedShader (fileName);
+		if (shader == nullptr) {
+			throw std::runtime_error (std::string ("Shader ") + fileName + " was not embedded by the build...");
+		}
+		shaderModules.push_back ({fileName, CreateShaderModule (shader->code, shader->codeSize)});
+	}
 
-	viewCreateInfo.subresourceRange.aspectMask = aspectFlags;
-	viewCreateInfo.subresourceRange.baseMipLevel = 0;
-	viewCreateInfo.subresourceRange.levelCount = 1;
-	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
-	viewCreateInfo.subresourceRange.layerCount = 1;
+	// every graphics pipeline shares the layout, so the bindless set stays bound across pipeline switches
+	VkDescriptorSetLayout bindlessSetLayout = bindlessHeap.GetSetLayout ();
+	VkPushConstantRange drawIndicesRange {};
+	drawIndicesRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	drawIndicesRange.offset = 0;
+	drawIndicesRange.size = sizeof (DrawIndices);
+
+	if (useBindless) {
+		const EmbeddedShader* shader = FindEmbeddedShader ("frag_bindless.spv");
+		if (shader == nullptr) {
+			throw std::runtime_error ("Shader frag_bindless.spv was not embedded by the build...");
+		}
+		shaderModules.push_back ({"frag_bindless.spv", CreateShaderModule (shader->code, shader->codeSize)});
+		bindlessFragmentModule = static_cast<uint32_t> (shaderModules.size () - 1);
+	}
 
-	VkImageView imageView;
-	VkResult result = vkCreateImageView (mainDevice.logicalDevice, &viewCreateInfo, nullptr, &imageView);
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = useBindless ? 1 : 0;
+	pipelineLayoutCreateInfo.pSetLayouts = useBindless ? &bindlessSetLayout : nullptr;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = useBindless ? 1 : 0;
+	pipelineLayoutCreateInfo.pPushConstantRanges = useBindless ? &drawIndicesRange : nullptr;
 
+	VkResult result = vkCreatePipelineLayout (mainDevice.logicalDevice, &pipelineLayoutCreateInfo, hostAllocator, &pipelineLayout);
 	if (result != VK_SUCCESS) {
-		throw std::runtime_error ("Failed to create an image view..");
+		throw std::runtime_error ("Failed to create pipeline layout...");
 	}
 
-	return imageView;
+	GraphicsPipeline graphicsPipeline {};
+	graphicsPipeline.variant = 0;
+	graphicsPipeline.vertexModule = 0;
+	graphicsPipeline.fragmentModule = 1;
+	graphicsPipeline.stateHash = HashPipelineState (graphicsPipeline);
+	graphicsPipeline.pipeline = CreateGraphicsPipelineVariant (graphicsPipeline, shaderModules[0].module, shaderModules[1].module);
+	graphicsPipelines.push_back (graphicsPipeline);
 }
 
 
-void VulkanRenderer::CreateGraphicsPipeline ()
+VkPipeline VulkanRenderer::CreateGraphicsPipelineVariant (const GraphicsPipeline& description, VkShaderModule vertexModule, VkShaderModule fragmentModule)
 {
-	auto vertexShaderCode = ReadFile ("../Shaders/vert.spv");
-	auto fragmentShaderCode = ReadFile ("../Shaders/frag.spv");
-
-	VkShaderModule vertexShaderModule = CreateShaderModule (vertexShaderCode);
-	VkShaderModule fragmentShaderModule = CreateShaderModule (fragmentShaderCode);
+	// unset constants keep the defaults declared in the shader
+	VkSpecializationInfo vertexSpecializationInfo = description.vertexConstants.GetInfo ();
+	VkSpecializationInfo fragmentSpecializationInfo = description.fragmentConstants.GetInfo ();
 
 	VkPipelineShaderStageCreateInfo vertexShaderCreateInfo {};
 	vertexShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertexShaderCreateInfo.module = vertexShaderModule;
+	vertexShaderCreateInfo.module = vertexModule;
 	vertexShaderCreateInfo.pName = "main";
+	vertexShaderCreateInfo.pSpecializationInfo = description.vertexConstants.IsEmpty () ? nullptr : &vertexSpecializationInfo;
 
 	VkPipelineShaderStageCreateInfo fragmentShaderCreateInfo {};
 	fragmentShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragmentShaderCreateInfo.module = fragmentShaderModule;
+	fragmentShaderCreateInfo.module = fragmentModule;
 	fragmentShaderCreateInfo.pName = "main";
+	fragmentShaderCreateInfo.pSpecializationInfo = description.fragmentConstants.IsEmpty () ? nullptr : &fragmentSpecializationInfo;
 
 	VkPipelineShaderStageCreateInfo shaderStages[] {vertexShaderCreateInfo, fragmentShaderCreateInfo};
 
@@ -500,36 +1824,24 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VkViewport viewport {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float> (swapchainExtent.width);
-	viewport.height = static_cast<float> (swapchainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor {};
-	scissor.offset = {0, 0};
-	scissor.extent = swapchainExtent;
-
+	// viewport and scissor are set while recording, so a resize does not rebuild pipelines
 	VkPipelineViewportStateCreateInfo viewportCreateInfo {};
 	viewportCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportCreateInfo.viewportCount = 1;
-	viewportCreateInfo.pViewports = &viewport;
+	viewportCreateInfo.pViewports = nullptr;
 	viewportCreateInfo.scissorCount = 1;
-	viewportCreateInfo.pScissors = &scissor;
+	viewportCreateInfo.pScissors = nullptr;
 
 	// dynamic part of the pipeline
-	/*
-	std::vector<VkDynamicState> dynamicStateEnables;
-	dynamicStateEnables.push_back (VK_DYNAMIC_STATE_VIEWPORT);
-	dynamicStateEnables.push_back (VK_DYNAMIC_STATE_SCISSOR);
+	std::array<VkDynamicState, 2> dynamicStateEnables = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
 
-	VkPipelineDynamicStateCreateInfo dynamicStateCrateInfo;
-	dynamicStateCrateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamicStateCrateInfo.dynamicStateCount = static_cast<uint32_t> (dynamicStateEnables.size ());
-	dynamicStateCrateInfo.pDynamicStates = dynamicStateEnables.data ();
-	*/
+	VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo {};
+	dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t> (dynamicStateEnables.size ());
+	dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data ();
 
 	VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo {};
 	rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -537,7 +1849,10 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
 	rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
 	rasterizationStateCreateInfo.lineWidth = 1.0f;
-	rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	// each bit of the variant changes state the driver bakes into the pipeline, in ways that give the
+	// same image for the opaque output of shader.frag. Variants past 64 repeat the state
+	uint32_t variantBits = description.variant;
+	rasterizationStateCreateInfo.cullMode = (variantBits & 1) != 0 ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
 	rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
 	rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;
 
@@ -549,12 +1864,13 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	VkPipelineColorBlendAttachmentState colorBlendAttachmentState {};
 	colorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendAttachmentState.blendEnable = VK_TRUE;
-	colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-	colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+	// with a source alpha of 1 every combination below writes the source color and alpha
+	colorBlendAttachmentState.srcColorBlendFactor = (variantBits & 2) != 0 ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_SRC_ALPHA;
+	colorBlendAttachmentState.dstColorBlendFactor = (variantBits & 4) != 0 ? VK_BLEND_FACTOR_ZERO : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachmentState.colorBlendOp = (variantBits & 8) != 0 ? VK_BLEND_OP_SUBTRACT : VK_BLEND_OP_ADD;
 	colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachmentState.dstAlphaBlendFactor = (variantBits & 16) != 0 ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachmentState.alphaBlendOp = (variantBits & 32) != 0 ? VK_BLEND_OP_SUBTRACT : VK_BLEND_OP_ADD;
 
 	VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo {};
 	colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -562,18 +1878,6 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	colorBlendingCreateInfo.attachmentCount = 1;
 	colorBlendingCreateInfo.pAttachments = &colorBlendAttachmentState;
 
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
-	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCreateInfo.setLayoutCount = 0;
-	pipelineLayoutCreateInfo.pSetLayouts = nullptr;
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-
-	VkResult result = vkCreatePipelineLayout (mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error ("Failed to create pipeline layout...");
-	}
-
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo {};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineCreateInfo.stageCount = 2;
@@ -581,7 +1885,7 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	pipelineCreateInfo.pVertexInputState = &vertexInputStateCreateInfo;
 	pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
 	pipelineCreateInfo.pViewportState = &viewportCreateInfo;
-	pipelineCreateInfo.pDynamicState = nullptr;
+	pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
 	pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
 	pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
 	pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
@@ -593,25 +1897,180 @@ void VulkanRenderer::CreateGraphicsPipeline ()
 	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineCreateInfo.basePipelineIndex = -1;
 
-	result = vkCreateGraphicsPipelines (mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline);
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines (mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, hostAllocator, &pipeline);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a graphics pipeline...");
 	}
 
-	vkDestroyShaderModule (mainDevice.logicalDevice, fragmentShaderModule, nullptr);
-	vkDestroyShaderModule (mainDevice.logicalDevice, vertexShaderModule, nullptr);
+	return pipeline;
+}
+
+
+void VulkanRenderer::CreateComputePipelines ()
+{
+	if (queueFamilies.computeFamily < 0) {
+		return;
+	}
+
+	// the frame the graphics pass rendered, processed in place
+	VkDescriptorSetLayoutBinding frameBinding {};
+	frameBinding.binding = 0;
+	frameBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	frameBinding.descriptorCount = 1;
+	frameBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// 16x16 where the device allows it, 8x8 fits the 128 invocations every device has to support
+	const VkPhysicalDeviceLimits& limits = deviceProperties.limits;
+	uint32_t groupSize = limits.maxComputeWorkGroupInvocations >= 256 &&
+						 limits.maxComputeWorkGroupSize[0] >= 16 && limits.maxComputeWorkGroupSize[1] >= 16 ? 16 : 8;
+
+	AddComputePipeline ("comp.spv", {frameBinding}, groupSize, groupSize);
+}
+
+
+VkPipeline VulkanRenderer::CreateComputePipeline (const ComputePipeline& description, VkShaderModule shaderModule)
+{
+	VkSpecializationInfo specializationInfo = description.constants.GetInfo ();
+
+	VkPipelineShaderStageCreateInfo shaderCreateInfo {};
+	shaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	shaderCreateInfo.module = shaderModule;
+	shaderCreateInfo.pName = "main";
+	shaderCreateInfo.pSpecializationInfo = description.constants.IsEmpty () ? nullptr : &specializationInfo;
+
+	VkComputePipelineCreateInfo pipelineCreateInfo {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage = shaderCreateInfo;
+	pipelineCreateInfo.layout = description.layout;
+	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineCreateInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines (mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, hostAllocator, &pipeline);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a compute pipeline...");
+	}
+
+	return pipeline;
+}
+
+
+uint32_t VulkanRenderer::FindOrAddShaderModule (const std::string& fileName)
+{
+	auto found = std::find_if (shaderModules.begin (), shaderModules.end (), [&fileName] (const ShaderModule& shaderModule) {
+		return shaderModule.fileName == fileName;
+	});
+	if (found != shaderModules.end ()) {
+		return static_cast<uint32_t> (found - shaderModules.begin ());
+	}
+
+	const EmbeddedShader* shader = FindEmbeddedShader (fileName);
+	if (shader == nullptr) {
+		throw std::runtime_error ("Shader " + fileName + " was not embedded by the build...");
+	}
+	shaderModules.push_back ({fileName, CreateShaderModule (shader->code, shader->codeSize)});
+	return static_cast<uint32_t> (shaderModules.size () - 1);
+}
+
+
+void VulkanRenderer::CreateComputeDescriptorPool ()
+{
+	// room for the usual compute resources, AllocateComputeDescriptorSet adds pools as they fill
+	constexpr uint32_t SetsPerPool = 64;
+	std::array<VkDescriptorPoolSize, 5> poolSizes {{
+		{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 4 * SetsPerPool},
+		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * SetsPerPool},
+		{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 * SetsPerPool},
+		{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4 * SetsPerPool},
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 * SetsPerPool}
+	}};
+
+	VkDescriptorPoolCreateInfo poolCreateInfo {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = SetsPerPool;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t> (poolSizes.size ());
+	poolCreateInfo.pPoolSizes = poolSizes.data ();
+
+	VkDescriptorPool descriptorPool;
+	VkResult result = vkCreateDescriptorPool (mainDevice.logicalDevice, &poolCreateInfo, hostAllocator, &descriptorPool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a descriptor pool...");
+	}
+	computeDescriptorPools.push_back (descriptorPool);
+}
+
+
+void VulkanRenderer::CreatePostProcessDescriptors ()
+{
+	// sets still bound by frames in flight go with the old pool once those complete
+	if (postProcessDescriptorPool != VK_NULL_HANDLE) {
+		DestroyDeferred (postProcessDescriptorPool);
+		postProcessDescriptorPool = VK_NULL_HANDLE;
+	}
+	postProcessDescriptorSets.clear ();
+
+	if (!IsPostProcessSupported ()) {
+		return;
+	}
+
+	VkDescriptorPoolSize poolSize {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSize.descriptorCount = static_cast<uint32_t> (swapchainImages.size ());
+
+	VkDescriptorPoolCreateInfo poolCreateInfo {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = static_cast<uint32_t> (swapchainImages.size ());
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkResult result = vkCreateDescriptorPool (mainDevice.logicalDevice, &poolCreateInfo, hostAllocator, &postProcessDescriptorPool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a descriptor pool...");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts (swapchainImages.size (), computePipelines.front ().setLayout);
+	postProcessDescriptorSets.resize (swapchainImages.size ());
+
+	VkDescriptorSetAllocateInfo setAllocateInfo {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = postProcessDescriptorPool;
+	setAllocateInfo.descriptorSetCount = static_cast<uint32_t> (setLayouts.size ());
+	setAllocateInfo.pSetLayouts = setLayouts.data ();
+
+	result = vkAllocateDescriptorSets (mainDevice.logicalDevice, &setAllocateInfo, postProcessDescriptorSets.data ());
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate descriptor sets...");
+	}
+
+	for (size_t i = 0; i < swapchainImages.size (); ++i) {
+		VkDescriptorImageInfo imageInfo {};
+		imageInfo.imageView = swapchainImages[i].imageView;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet descriptorWrite {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = postProcessDescriptorSets[i];
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets (mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
+	}
 }
 
 
-VkShaderModule VulkanRenderer::CreateShaderModule (const std::vector<char> &code)
+VkShaderModule VulkanRenderer::CreateShaderModule (const uint32_t* code, size_t codeSize)
 {
 	VkShaderModuleCreateInfo shaderModuleCreateInfo {};
 	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shaderModuleCreateInfo.codeSize = code.size ();
-	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*> (code.data ());
+	shaderModuleCreateInfo.codeSize = codeSize;
+	shaderModuleCreateInfo.pCode = code;
 
 	VkShaderModule shaderModule;
-	VkResult result = vkCreateShaderModule (mainDevice.logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
+	VkResult result = vkCreateShaderModule (mainDevice.logicalDevice, &shaderModuleCreateInfo, hostAllocator, &shaderModule);
 
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a shader module...");
@@ -632,7 +2091,8 @@ void VulkanRenderer::CreateRenderPass ()
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// offscreen targets are left ready to be copied out
+	colorAttachment.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference colorAttachmentReference {};
 	colorAttachmentReference.attachment = 0;
@@ -660,8 +2120,8 @@ void VulkanRenderer::CreateRenderPass ()
 	subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 	// but before...
 	subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	subpassDependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	subpassDependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
 	subpassDependencies[1].dependencyFlags = 0;
 
 	VkRenderPassCreateInfo renderPassCreateInfo {};
@@ -673,7 +2133,7 @@ void VulkanRenderer::CreateRenderPass ()
 	renderPassCreateInfo.dependencyCount = static_cast<uint32_t> (subpassDependencies.size ());
 	renderPassCreateInfo.pDependencies = subpassDependencies.data ();
 
-	VkResult result = vkCreateRenderPass (mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
+	VkResult result = vkCreateRenderPass (mainDevice.logicalDevice, &renderPassCreateInfo, hostAllocator, &renderPass);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a render pass...");
 	}
@@ -697,7 +2157,7 @@ void VulkanRenderer::CreateFrameBuffers ()
 		framebufferCreateInfo.height = swapchainExtent.height;
 		framebufferCreateInfo.layers = 1;
 
-		VkResult result = vkCreateFramebuffer (mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &swapchainFrameBuffers[i]);
+		VkResult result = vkCreateFramebuffer (mainDevice.logicalDevice, &framebufferCreateInfo, hostAllocator, &swapchainFrameBuffers[i]);
 		if (result != VK_SUCCESS) {
 			throw std::runtime_error ("Failed to create framebuffer...");
 		}
@@ -707,13 +2167,24 @@ void VulkanRenderer::CreateFrameBuffers ()
 
 void VulkanRenderer::CreateCommandPool ()
 {
-	QueueFamilyIndices queueFamilyIndices = GetQueueFamilies (mainDevice.physicalDevice);
+	const QueueFamilyIndices& queueFamilyIndices = queueFamilies;
 
 	VkCommandPoolCreateInfo poolCreateInfo {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 	poolCreateInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
 
-	VkResult result = vkCreateCommandPool (mainDevice.logicalDevice, &poolCreateInfo, nullptr, &graphicsCommandPool);
+	VkResult result = vkCreateCommandPool (mainDevice.logicalDevice, &poolCreateInfo, hostAllocator, &graphicsCommandPool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to create a command pool...");
+	}
+
+	if (queueFamilyIndices.computeFamily < 0) {
+		return;
+	}
+
+	poolCreateInfo.queueFamilyIndex = queueFamilyIndices.computeFamily;
+	result = vkCreateCommandPool (mainDevice.logicalDevice, &poolCreateInfo, hostAllocator, &computeCommandPool);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to create a command pool...");
 	}
@@ -722,7 +2193,8 @@ void VulkanRenderer::CreateCommandPool ()
 
 void VulkanRenderer::CreateCommandBuffers ()
 {
-	commandBuffers.resize (swapchainFrameBuffers.size ());
+	// one per frame in flight, re-recorded every frame once its fence has signaled
+	commandBuffers.resize (MaxFrameDraws);
 
 	VkCommandBufferAllocateInfo commandBufferAllocateInfo {};
 	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -734,14 +2206,38 @@ void VulkanRenderer::CreateCommandBuffers ()
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to allocate command buffers...");
 	}
+
+	if (computeCommandPool == VK_NULL_HANDLE) {
+		return;
+	}
+
+	computeCommandBuffers.resize (MaxFrameDraws);
+	commandBufferAllocateInfo.commandPool = computeCommandPool;
+
+	result = vkAllocateCommandBuffers (mainDevice.logicalDevice, &commandBufferAllocateInfo, computeCommandBuffers.data ());
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to allocate command buffers...");
+	}
 }
 
 
-void VulkanRenderer::RecordCommands ()
+void VulkanRenderer::RecordCommands (uint32_t imageIndex)
 {
+	VkCommandBuffer commandBuffer = commandBuffers[currentFrame];
+
+	// resolved up front, so the recording loop only reads what it records
+	size_t drawPacketCount = visibleDraws.size ();
+	DrawPacket* drawPackets = frameArenas[currentFrame].Allocate<DrawPacket> (drawPacketCount);
+	for (size_t i = 0; i < drawPacketCount; ++i) {
+		const DrawCommand& drawCommand = drawCommands[visibleDraws[i]];
+		// AddDraw and SetPipelineCount keep every index in range
+		drawPackets[i] = {graphicsPipelines[drawCommand.pipelineIndex].pipeline, drawCommand.vertexCount, drawCommand.instanceCount,
+						  drawCommand.firstVertex, {drawCommand.textureIndex, drawCommand.materialIndex}};
+	}
+
 	VkCommandBufferBeginInfo beginInfo {};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	// beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 	VkRenderPassBeginInfo renderPassBeginInfo {};
 	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -753,73 +2249,451 @@ void VulkanRenderer::RecordCommands ()
 	};
 	renderPassBeginInfo.pClearValues = clearValues;
 	renderPassBeginInfo.clearValueCount = 1;
+	renderPassBeginInfo.framebuffer = swapchainFrameBuffers[imageIndex];
+
+	VkViewport viewport {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float> (swapchainExtent.width);
+	viewport.height = static_cast<float> (swapchainExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
 
-	for (size_t i = 0; i < commandBuffers.size (); ++i) {
-		renderPassBeginInfo.framebuffer = swapchainFrameBuffers[i];
+	VkRect2D scissor {};
+	scissor.offset = {0, 0};
+	scissor.extent = swapchainExtent;
 
-		VkResult result = vkBeginCommandBuffer (commandBuffers[i], &beginInfo);
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error ("Failed to start recording a command buffer...");
+	VkResult result = vkBeginCommandBuffer (commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to start recording a command buffer...");
+	}
+
+		if (uploadBytesPerFrame != 0) {
+			// every frame writes the same target, so order the copy after the previous frame's
+			VkMemoryBarrier uploadBarrier {};
+			uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			uploadBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+								  1, &uploadBarrier, 0, nullptr, 0, nullptr);
+
+			VkBufferCopy uploadRegion {};
+			uploadRegion.size = uploadBytesPerFrame;
+			vkCmdCopyBuffer (commandBuffer, uploadStagingBuffers[currentFrame], uploadTargetBuffer, 1, &uploadRegion);
+		}
+
+		RecordDispatches (commandBuffer, ComputeQueue::Graphics);
+
+		vkCmdBeginRenderPass (commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			vkCmdSetViewport (commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor (commandBuffer, 0, 1, &scissor);
+
+			// bound once, draws only push the indices into it that change
+			DrawIndices pushedIndices {std::numeric_limits<uint32_t>::max (), std::numeric_limits<uint32_t>::max ()};
+			if (useBindless) {
+				VkDescriptorSet bindlessSet = bindlessHeap.GetDescriptorSet ();
+				vkCmdBindDescriptorSets (commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &bindlessSet, 0, nullptr);
+			}
+
+			VkPipeline boundPipeline = VK_NULL_HANDLE;
+			for (size_t i = 0; i < drawPacketCount; ++i) {
+				const DrawPacket& drawPacket = drawPackets[i];
+
+				if (drawPacket.pipeline != boundPipeline) {
+					vkCmdBindPipeline (commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPacket.pipeline);
+					boundPipeline = drawPacket.pipeline;
+				}
+
+				if (useBindless && (drawPacket.indices.textureIndex != pushedIndices.textureIndex ||
+									drawPacket.indices.materialIndex != pushedIndices.materialIndex))
+				{
+					pushedIndices = drawPacket.indices;
+					vkCmdPushConstants (commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof (DrawIndices), &pushedIndices);
+				}
+
+				vkCmdDraw (commandBuffer, drawPacket.vertexCount, drawPacket.instanceCount, drawPacket.firstVertex, 0);
+			}
+
+		vkCmdEndRenderPass (commandBuffer);
+
+		// with post-processing the compute pass is the last writer, it records the copy instead
+		if (!postProcessEnabled && frameReadbackSlots[currentFrame] >= 0) {
+			RecordReadback (commandBuffer, imageIndex, readbackSlots[frameReadbackSlots[currentFrame]]);
+		}
+
+	result = vkEndCommandBuffer (commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to stop recording a command buffer...");
+	}
+}
+
+
+void VulkanRenderer::RecordComputeCommands (uint32_t imageIndex)
+{
+	VkCommandBuffer commandBuffer = computeCommandBuffers[currentFrame];
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VkResult result = vkBeginCommandBuffer (commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to start recording a command buffer...");
+	}
+
+		RecordDispatches (commandBuffer, ComputeQueue::Compute);
+
+		if (postProcessEnabled) {
+			// the semaphore from the graphics submit already made the color writes visible, the barrier
+			// only changes the layout. The images are shared between the families, no ownership transfer
+			VkImageLayout finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+			VkImageMemoryBarrier imageBarrier {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.oldLayout = finalLayout;
+			imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			imageBarrier.srcAccessMask = 0;
+			imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = swapchainImages[imageIndex].image;
+			imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+			vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+								  0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+			// the post-process is the first compute pipeline, dispatched like any other
+			RecordDispatch (commandBuffer, {0, postProcessDescriptorSets[imageIndex], swapchainExtent.width, swapchainExtent.height, 1, ComputeQueue::Compute});
+
+			imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			imageBarrier.newLayout = finalLayout;
+			imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+								  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+								  0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+			if (frameReadbackSlots[currentFrame] >= 0) {
+				RecordReadback (commandBuffer, imageIndex, readbackSlots[frameReadbackSlots[currentFrame]]);
+			}
 		}
 
-			vkCmdBeginRenderPass (commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	result = vkEndCommandBuffer (commandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error ("Failed to stop recording a command buffer...");
+	}
+}
+
+
+void VulkanRenderer::RecordDispatches (VkCommandBuffer commandBuffer, ComputeQueue queue)
+{
+	if (queue == ComputeQueue::Graphics ? computeDispatches.size () == computeQueueDispatchCount : computeQueueDispatchCount == 0) {
+		return;
+	}
+
+	// submits on one queue are not ordered by themselves: the previous frame's shaders are done
+	// with whatever these dispatches write, and its dispatches' writes are visible to them
+	VkPipelineStageFlags previousStages = queue == ComputeQueue::Graphics
+		? VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+		: VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	VkMemoryBarrier memoryBarrier {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier (commandBuffer, previousStages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+						  1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+	for (const auto& dispatch : computeDispatches) {
+		if (dispatch.queue == queue) {
+			RecordDispatch (commandBuffer, dispatch);
+		}
+	}
+
+	// the frame's draws read what the dispatches wrote
+	if (queue == ComputeQueue::Graphics) {
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+									  VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+							  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+							  VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+							  1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+
+void VulkanRenderer::RecordDispatch (VkCommandBuffer commandBuffer, const ComputeDispatch& dispatch)
+{
+	const ComputePipeline& computePipeline = computePipelines[dispatch.pipelineIndex];
+
+	vkCmdBindPipeline (commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.pipeline);
+	if (dispatch.descriptorSet != VK_NULL_HANDLE) {
+		vkCmdBindDescriptorSets (commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.layout, 0,
+								 1, &dispatch.descriptorSet, 0, nullptr);
+	}
+
+	vkCmdDispatch (commandBuffer, (dispatch.width + computePipeline.groupWidth - 1) / computePipeline.groupWidth,
+				   (dispatch.height + computePipeline.groupHeight - 1) / computePipeline.groupHeight, dispatch.depth);
+}
+
+
+void VulkanRenderer::RecordReadback (VkCommandBuffer commandBuffer, uint32_t imageIndex, const ReadbackSlot& readbackSlot)
+{
+	VkImage image = swapchainImages[imageIndex].image;
+
+	// offscreen targets already end the render pass in TRANSFER_SRC, swapchain images are moved
+	// there and back; the render pass exit dependency orders the color writes before the copy
+	VkImageMemoryBarrier imageBarrier {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = image;
+	imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	if (!headless) {
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcAccessMask = 0;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &imageBarrier);
+	}
+
+	VkBufferImageCopy copyRegion {};
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageExtent = {swapchainExtent.width, swapchainExtent.height, 1};
+	vkCmdCopyImageToBuffer (commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackSlot.buffer, 1, &copyRegion);
+
+	if (!headless) {
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		imageBarrier.srcAccessMask = 0;
+		imageBarrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &imageBarrier);
+	}
+
+	VkBufferMemoryBarrier hostBarrier {};
+	hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hostBarrier.buffer = readbackSlot.buffer;
+	hostBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+						  0, nullptr, 1, &hostBarrier, 0, nullptr);
+}
+
+
+void VulkanRenderer::Update ()
+{
+	PollCompletedFrames ();
+
+	// the slot may still be in flight here, Draw moves this into frameStartTimes once it has retired
+	nextFrameStart = std::chrono::steady_clock::now ();
+	nextFrameStartSet = true;
 
-				vkCmdBindPipeline (commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	frustumCuller.Cull (visibleDraws, cullingThreadCount);
+}
+
+
+bool VulkanRenderer::IsFrameComplete (int frame)
+{
+	if (useTimelineSync) {
+		return graphicsTimeline.GetCompletedValue () >= frameSerials[frame] &&
+			   (frameComputeValues[frame] == 0 || computeTimeline.GetCompletedValue () >= frameComputeValues[frame]);
+	}
+
+	VkResult status = vkGetFenceStatus (mainDevice.logicalDevice, drawFences[frame]);
+	if (status != VK_SUCCESS && status != VK_NOT_READY) {
+		throw std::runtime_error ("Lost the device while waiting for a frame...");
+	}
 
-				vkCmdDraw (commandBuffers[i], 3, 1, 0, 0);
+	return status == VK_SUCCESS;
+}
 
-			vkCmdEndRenderPass (commandBuffers[i]);
 
-		result = vkEndCommandBuffer (commandBuffers[i]);
+void VulkanRenderer::WaitForFrame (int frame)
+{
+	// one blocking wait covers the frame and everything submitted before it on the queue
+	if (useTimelineSync) {
+		graphicsTimeline.Wait (frameSerials[frame], std::numeric_limits<uint64_t>::max ());
+		if (frameComputeValues[frame] != 0) {
+			computeTimeline.Wait (frameComputeValues[frame], std::numeric_limits<uint64_t>::max ());
+		}
+	} else {
+		VkResult result = vkWaitForFences (mainDevice.logicalDevice, 1, &drawFences[frame], VK_TRUE, std::numeric_limits<uint64_t>::max ());
 		if (result != VK_SUCCESS) {
-			throw std::runtime_error ("Failed to stop recording a command buffer...");
+			throw std::runtime_error ("Lost the device while waiting for a frame...");
 		}
 	}
+
+	PollCompletedFrames ();
 }
 
 
-void VulkanRenderer::Draw ()
+void VulkanRenderer::PollCompletedFrames ()
+{
+	for (int frame = 0; frame < MaxFrameDraws; ++frame) {
+		if (framesInFlight[frame] && IsFrameComplete (frame)) {
+			framesInFlight[frame] = false;
+			completedSerial = std::max (completedSerial, frameSerials[frame]);
+
+			if (frameReadbackSlots[frame] >= 0) {
+				ReadbackSlot& readbackSlot = readbackSlots[frameReadbackSlots[frame]];
+				bool bgra = swapchainImageFormat == VK_FORMAT_B8G8R8A8_UNORM || swapchainImageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+				captureWriter->Submit ({readbackSlot.frameNumber, swapchainExtent.width, swapchainExtent.height, bgra,
+										readbackSlot.data, &readbackSlot.inUse});
+				frameReadbackSlots[frame] = -1;
+			}
+
+			if (framePacer != nullptr) {
+				std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now () - frameStartTimes[frame];
+				framePacer->RecordLatency (latency.count ());
+			}
+		}
+	}
+}
+
+
+uint64_t VulkanRenderer::GetCompletedSerial ()
 {
-	vkWaitForFences (mainDevice.logicalDevice, 1, &drawFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max ());
-	vkResetFences (mainDevice.logicalDevice, 1, &drawFences[currentFrame]);
+	// a serial is only complete once both queues are past it, which the frames in flight track
+	if (useTimelineSync) {
+		PollCompletedFrames ();
+	}
+
+	return completedSerial;
+}
+
 
-	uint32_t imageIndex;
-	vkAcquireNextImageKHR (mainDevice.logicalDevice,
-						   swapchain,
-						   std::numeric_limits<uint64_t>::max (),
-						   imagesAvailable[currentFrame],
-						   VK_NULL_HANDLE,
-						   &imageIndex);
+uint64_t VulkanRenderer::SubmitFrame (VkQueue queue, TimelineSemaphore& timeline, VkCommandBuffer commandBuffer,
+									  VkSemaphore waitSemaphore, uint64_t waitValue, VkPipelineStageFlags waitStage, bool lastSubmit)
+{
+	// the last submit of a frame signals present and the frame fence, an earlier one hands over to it
+	FrameArena& frameArena = frameArenas[currentFrame];
+	VkSemaphore* signalSemaphores = frameArena.Allocate<VkSemaphore> (2);
+	uint64_t* signalValues = frameArena.Allocate<uint64_t> (2);
+	uint32_t signalCount = 0;
+	if (lastSubmit && !headless) {
+		signalSemaphores[signalCount] = rendersFinished[currentFrame];
+		signalValues[signalCount++] = 0;
+	}
 
 	VkSubmitInfo submitInfo {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &imagesAvailable[currentFrame];
-	VkPipelineStageFlags waitStages[] = {
-			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-	};
-	submitInfo.pWaitDstStageMask = waitStages;
+	submitInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+	submitInfo.pWaitSemaphores = &waitSemaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = &rendersFinished[currentFrame];
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	VkFence submitFence = VK_NULL_HANDLE;
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo {};
+	uint64_t signaledValue = 0;
+
+	if (useTimelineSync) {
+		// binary semaphores still feed present and acquire, their values are ignored
+		signaledValue = timeline.NextValue ();
+		signalSemaphores[signalCount] = timeline.GetSemaphore ();
+		signalValues[signalCount++] = signaledValue;
+
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+		timelineSubmitInfo.pWaitSemaphoreValues = &waitValue;
+		timelineSubmitInfo.signalSemaphoreValueCount = signalCount;
+		timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+
+		submitInfo.pNext = &timelineSubmitInfo;
+	} else if (lastSubmit) {
+		submitFence = drawFences[currentFrame];
+	} else {
+		signalSemaphores[signalCount++] = graphicsFinished[currentFrame];
+	}
+
+	submitInfo.signalSemaphoreCount = signalCount;
+	submitInfo.pSignalSemaphores = signalSemaphores;
 
- 	VkResult result = vkQueueSubmit (graphicsQueue, 1, &submitInfo, drawFences[currentFrame]);
+	VkResult result = vkQueueSubmit (queue, 1, &submitInfo, submitFence);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error ("Failed to submit command buffer to queue...");
 	}
 
-	VkPresentInfoKHR presentInfo {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = &rendersFinished[currentFrame];
-	presentInfo.swapchainCount = 1;
-	presentInfo.pSwapchains = &swapchain;
-	presentInfo.pImageIndices = &imageIndex;
+	return signaledValue;
+}
 
-	result = vkQueuePresentKHR (presentationQueue, &presentInfo);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error ("Failed to present an image...");
+
+void VulkanRenderer::Draw ()
+{
+	WaitForFrame (currentFrame);
+	if (!useTimelineSync) {
+		vkResetFences (mainDevice.logicalDevice, 1, &drawFences[currentFrame]);
+	}
+	frameArenas[currentFrame].Reset ();
+
+	// a frame drawn without an Update starts here
+	frameStartTimes[currentFrame] = nextFrameStartSet ? nextFrameStart : std::chrono::steady_clock::now ();
+	nextFrameStartSet = false;
+
+	deletionQueue.Collect (GetCompletedSerial ());
+	bindlessHeap.Collect (GetCompletedSerial ());
+
+	// headless frames render into the offscreen target owned by their frame slot
+	uint32_t imageIndex = static_cast<uint32_t> (currentFrame);
+	if (!headless) {
+		vkAcquireNextImageKHR (mainDevice.logicalDevice,
+							   swapchain,
+							   std::numeric_limits<uint64_t>::max (),
+							   imagesAvailable[currentFrame],
+							   VK_NULL_HANDLE,
+							   &imageIndex);
+	}
+
+	if (uploadBytesPerFrame != 0) {
+		std::memset (uploadStagingData[currentFrame], static_cast<int> (lastSubmittedSerial & 0xFF), static_cast<size_t> (uploadBytesPerFrame));
+	}
+
+	frameReadbackSlots[currentFrame] = captureWriter != nullptr ? AcquireReadbackSlot () : -1;
+
+	RecordCommands (imageIndex);
+
+	bool computeSubmit = UsesComputeSubmit ();
+	if (computeSubmit) {
+		RecordComputeCommands (imageIndex);
+	}
+
+	// with a compute submit the graphics submit only hands the frame to compute, which finishes it
+	VkSemaphore imageAvailable = headless ? VK_NULL_HANDLE : imagesAvailable[currentFrame];
+	uint64_t graphicsValue = SubmitFrame (graphicsQueue, graphicsTimeline, commandBuffers[currentFrame], imageAvailable, 0,
+										  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, !computeSubmit);
+	frameSerials[currentFrame] = useTimelineSync ? graphicsValue : lastSubmittedSerial + 1;
+	frameComputeValues[currentFrame] = computeTimeline.GetLastSubmittedValue ();
+
+	if (computeSubmit) {
+		VkSemaphore handover = useTimelineSync ? graphicsTimeline.GetSemaphore () : graphicsFinished[currentFrame];
+		frameComputeValues[currentFrame] = SubmitFrame (computeQueue, computeTimeline, computeCommandBuffers[currentFrame], handover, graphicsValue,
+														VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, true);
+	}
+
+	framesInFlight[currentFrame] = true;
+	lastSubmittedSerial = frameSerials[currentFrame];
+
+	if (!headless) {
+		VkPresentInfoKHR presentInfo {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &rendersFinished[currentFrame];
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapchain;
+		presentInfo.pImageIndices = &imageIndex;
+
+		VkResult result = vkQueuePresentKHR (presentationQueue, &presentInfo);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error ("Failed to present an image...");
+		}
 	}
 
 	currentFrame = (currentFrame + 1) % MaxFrameDraws;
@@ -830,7 +2704,7 @@ void VulkanRenderer::CreateSynchronization ()
 {
 	imagesAvailable.resize (MaxFrameDraws);
 	rendersFinished.resize (MaxFrameDraws);
-	drawFences.resize (MaxFrameDraws);
+	graphicsFinished.resize (useTimelineSync || computePipelines.empty () ? 0 : MaxFrameDraws);
 
 	VkSemaphoreCreateInfo semaphoreCreateInfo {};
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -840,12 +2714,30 @@ void VulkanRenderer::CreateSynchronization ()
 	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
 	for (size_t i = 0; i < MaxFrameDraws; ++i) {
-		if (vkCreateSemaphore (mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &imagesAvailable[i]) != VK_SUCCESS ||
-			vkCreateSemaphore (mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &rendersFinished[i]) != VK_SUCCESS ||
-			vkCreateFence (mainDevice.logicalDevice, &fenceCreateInfo, nullptr, &drawFences[i]) != VK_SUCCESS)
+		if (vkCreateSemaphore (mainDevice.logicalDevice, &semaphoreCreateInfo, hostAllocator, &imagesAvailable[i]) != VK_SUCCESS ||
+			vkCreateSemaphore (mainDevice.logicalDevice, &semaphoreCreateInfo, hostAllocator, &rendersFinished[i]) != VK_SUCCESS)
 		{
 			throw std::runtime_error ("Failed to create a semaphore / fence...");
 		}
 	}
+	for (auto& semaphore : graphicsFinished) {
+		if (vkCreateSemaphore (mainDevice.logicalDevice, &semaphoreCreateInfo, hostAllocator, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error ("Failed to create a semaphore / fence...");
+		}
+	}
 
+	if (useTimelineSync) {
+		graphicsTimeline.Create (mainDevice.logicalDevice, hostAllocator);
+		if (!computePipelines.empty ()) {
+			computeTimeline.Create (mainDevice.logicalDevice, hostAllocator);
+		}
+		return;
+	}
+
+	drawFences.resize (MaxFrameDraws);
+	for (size_t i = 0; i < MaxFrameDraws; ++i) {
+		if (vkCreateFence (mainDevice.logicalDevice, &fenceCreateInfo, hostAllocator, &drawFences[i]) != VK_SUCCESS) {
+			throw std::runtime_error ("Failed to create a semaphore / fence...");
+		}
+	}
 }
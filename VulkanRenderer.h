@@ -8,10 +8,22 @@
 #include <vector>
 #include <set>
 #include <array>
+#include <atomic>
+#include <chrono>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include "Utilities.h"
+#include "FrustumCuller.h"
+#include "FramePacer.h"
+#include "TimelineSemaphore.h"
+#include "DeletionQueue.h"
+#include "ImageIO.h"
+#include "DeviceSelection.h"
+#include "FrameCapture.h"
+#include "BindlessHeap.h"
+#include "FrameArena.h"
+#include "HostAllocation.h"
 
 class VulkanRenderer
 {
@@ -19,79 +31,304 @@ public:
 	VulkanRenderer ();
 
 	int InitRenderer (GLFWwindow* newWindow);
+	// renders into offscreen targets without a window, surface or swapchain
+	int InitHeadless (uint32_t width, uint32_t height);
+	// before Init: device index or UUID to use instead of the best scoring one, wins over VULKAN_DEVICE
+	void SetDeviceOverride (const std::string& newDeviceOverride) { deviceOverride = newDeviceOverride; }
+	// CPU side work for the next frame, runs while the GPU is still busy with the previous one
+	void Update ();
 	void Draw ();
+	void Resize (uint32_t width, uint32_t height);
+	void WaitIdle ();
+	// blocking copy of the last drawn offscreen frame, for tests and tools
+	void CaptureFrame (Image& image);
+	// every frame from here on is copied into a readback ring and handed to the writer once it
+	// completes; when the writer falls behind frames are dropped rather than stalling. nullptr stops
+	void SetFrameCaptureWriter (FrameCaptureWriter* newCaptureWriter);
+	uint64_t GetDroppedCaptureCount () const { return droppedCaptureCount; }
+	// also undoes a failed Init, calling it twice is harmless
 	void CleanUp ();
 
+	uint32_t AddDraw (const DrawCommand& drawCommand, const BoundingSphere& sphere, const BoundingBox& box);
+	void ClearDraws ();
+	void SetViewProjection (const glm::mat4& viewProjection);
+	void SetFramePacer (FramePacer* newFramePacer) { framePacer = newFramePacer; }
+	// grows or trims the pipeline list to pipelineCount, adding variants of the default pipeline that
+	// differ in baked raster and blend state but render the same image. Throws rather than trim a
+	// specialized or bindless pipeline or one a draw still uses
+	void SetPipelineCount (uint32_t pipelineCount);
+	// bytes written on the host and copied to a device local buffer every frame
+	void SetUploadBytesPerFrame (VkDeviceSize byteCount);
+	// call between frames; rebuilds only the pipelines using the module, the old ones are
+	// destroyed once the frames still using them complete. false keeps the old module
+	bool ReloadShaderModule (const std::string& fileName, const std::vector<uint32_t>& code);
+	// the default pipeline with its shaders specialized, for use as DrawCommand::pipelineIndex;
+	// asking twice for the same constants returns the same pipeline
+	uint32_t AddSpecializedPipeline (const SpecializationConstants& vertexConstants, const SpecializationConstants& fragmentConstants);
+	// runs Shaders/postprocess.comp over every frame after the graphics pass, on the compute queue,
+	// which is a separate engine overlapping the next frame's rendering where the device has one.
+	// Waits for the GPU, call it when setting up rather than every frame
+	void SetPostProcessEnabled (bool enabled, float vignetteStrength = 0.5f);
+	bool IsPostProcessSupported () const { return !computePipelines.empty () && swapchainStorage; }
+	// a compute pipeline with its own set 0 layout made from bindings, and a local size passed to the
+	// shader through ComputeGroupWidthConstant and ComputeGroupHeightConstant. The shader is one of
+	// the embedded ones and hot reloads like the graphics shaders. Throws without a compute queue
+	uint32_t AddComputePipeline (const std::string& shaderFileName, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+								 uint32_t groupWidth, uint32_t groupHeight, const SpecializationConstants& constants = {});
+	// a set for the pipeline's layout, freed with the renderer. Only write sets no frame in flight
+	// dispatches with; resources used on both queues need concurrent sharing when the families differ
+	VkDescriptorSet AllocateComputeDescriptorSet (uint32_t pipelineIndex);
+	void WriteComputeImage (VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type,
+							VkImageView imageView, VkImageLayout imageLayout, VkSampler sampler = VK_NULL_HANDLE);
+	void WriteComputeBuffer (VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type,
+							 VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+	// recorded into every frame from here on, like draws, in the order added on each queue. Adding the
+	// first or clearing the last compute queue dispatch waits for the GPU, as the frame's last submit moves
+	uint32_t AddDispatch (const ComputeDispatch& dispatch);
+	void ClearDispatches ();
+	// Vulkan 1.2 descriptor indexing, VULKAN_BINDLESS=0 turns it off; without it the calls below throw
+	bool IsBindlessSupported () const { return useBindless; }
+	// like AddSpecializedPipeline, with a fragment shader that reads DrawCommand::textureIndex and
+	// materialIndex from the bindless heap
+	uint32_t AddBindlessPipeline (const SpecializationConstants& vertexConstants = {}, const SpecializationConstants& fragmentConstants = {});
+	// a renderer owned 1x1 texture or tint material, returns its heap index; index 0 of each is white
+	uint32_t AddSolidTexture (const glm::vec4& color);
+	uint32_t AddMaterial (const glm::vec4& tint);
+	// caller owned resources; they have to outlive the frames drawn before the matching remove
+	uint32_t AddBindlessTexture (VkImageView imageView, VkImageLayout imageLayout);
+	uint32_t AddBindlessBuffer (VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+	void RemoveBindlessTexture (uint32_t index) { bindlessHeap.RemoveTexture (index, lastSubmittedSerial); }
+	void RemoveBindlessBuffer (uint32_t index) { bindlessHeap.RemoveBuffer (index, lastSubmittedSerial); }
+
+	// the handle must not be recorded into any frame after this call, it is freed once
+	// every frame submitted so far has completed
+	template <typename Handle>
+	void DestroyDeferred (Handle handle) { deletionQueue.Push (handle, lastSubmittedSerial); }
+
 	~VulkanRenderer ();
 
 private:
 	GLFWwindow* window;
+	bool headless = false;
+	VkExtent2D headlessExtent {};
 
 	int currentFrame = 0;
 
 	// vk components
 		// main components
-	VkInstance instance;
+	VkInstance instance = VK_NULL_HANDLE;
+	uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+	std::string deviceOverride;
 	struct {
-		VkPhysicalDevice physicalDevice;
-		VkDevice logicalDevice;
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		VkDevice logicalDevice = VK_NULL_HANDLE;
 	} mainDevice;
-	VkQueue graphicsQueue;
-	VkQueue presentationQueue;
-	VkSurfaceKHR surface;
-	VkSwapchainKHR swapchain;
+	// every object is created and destroyed with these, see HostAllocation.h
+	const VkAllocationCallbacks* hostAllocator = nullptr;
+	// queried once for the chosen device; only the surface capabilities change with the window
+	QueueFamilyIndices queueFamilies;
+	VkPhysicalDeviceProperties deviceProperties {};
+	VkPhysicalDeviceMemoryProperties memoryProperties {};
+	SwapchainDetails swapchainDetails {};
+	VkQueue graphicsQueue = VK_NULL_HANDLE;
+	VkQueue presentationQueue = VK_NULL_HANDLE;
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+	// in headless mode these are offscreen images owned by the renderer
 	std::vector<SwapchainImage> swapchainImages;
+	std::vector<VkDeviceMemory> offscreenImageMemory;
 	std::vector<VkFramebuffer> swapchainFrameBuffers;
 	std::vector<VkCommandBuffer> commandBuffers;
 
-	VkPipeline graphicsPipeline;
-	VkPipelineLayout pipelineLayout;
-	VkRenderPass renderPass;
+	std::vector<GraphicsPipeline> graphicsPipelines;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	std::vector<ShaderModule> shaderModules;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+
+	// the post-process pipeline comes first when there is a compute queue, then AddComputePipeline's
+	std::vector<ComputePipeline> computePipelines;
+	std::vector<ComputeDispatch> computeDispatches;
+	size_t computeQueueDispatchCount = 0;
+	// sets handed out by AllocateComputeDescriptorSet, a new pool whenever the last one is full
+	std::vector<VkDescriptorPool> computeDescriptorPools;
+	// one post-process set per frame image, rebuilt with the images
+	VkDescriptorPool postProcessDescriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> postProcessDescriptorSets;
+	bool postProcessEnabled = false;
+
+		// bindless resources, one set for every pipeline using pipelineLayout
+	bool useBindless = false;
+	BindlessHeap bindlessHeap;
+	VkSampler bindlessSampler = VK_NULL_HANDLE;
+	uint32_t bindlessFragmentModule = 0;
+	std::vector<VkImage> solidTextureImages;
+	std::vector<VkImageView> solidTextureViews;
+	std::vector<VkDeviceMemory> solidTextureMemory;
+	// every material is one vec4 in this buffer, each bound as its own heap entry
+	static constexpr uint32_t MaterialCapacity = 1024;
+	VkBuffer materialBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory materialMemory = VK_NULL_HANDLE;
+	uint8_t* materialData = nullptr;
+	VkDeviceSize materialStride = 0;
+	uint32_t materialCount = 0;
 
 		// pools
-	VkCommandPool graphicsCommandPool;
+	VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
+	VkCommandPool computeCommandPool = VK_NULL_HANDLE;
+	std::vector<VkCommandBuffer> computeCommandBuffers;
+
+		// per frame uploads
+	VkDeviceSize uploadBytesPerFrame = 0;
+	std::array<VkBuffer, MaxFrameDraws> uploadStagingBuffers {};
+	std::array<VkDeviceMemory, MaxFrameDraws> uploadStagingMemory {};
+	std::array<void*, MaxFrameDraws> uploadStagingData {};
+	VkBuffer uploadTargetBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory uploadTargetMemory = VK_NULL_HANDLE;
+
+		// frame capture readback, more slots than frames in flight so the writer can lag a little
+	static constexpr size_t ReadbackRingSize = MaxFrameDraws + 2;
+	struct ReadbackSlot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t* data = nullptr;
+		uint64_t frameNumber = 0;
+		// set while a frame copies into the slot or the writer reads it
+		std::atomic<bool> inUse {false};
+	};
+	FrameCaptureWriter* captureWriter = nullptr;
+	std::array<ReadbackSlot, ReadbackRingSize> readbackSlots;
+	// slot each frame in flight copies into, -1 for none
+	std::array<int, MaxFrameDraws> frameReadbackSlots;
+	uint64_t captureFrameNumber = 0;
+	uint64_t droppedCaptureCount = 0;
 
 		// utility components
 	VkFormat swapchainImageFormat;
 	VkExtent2D swapchainExtent;
+	bool swapchainTransferSource = false;
+	// the frame images can be bound as storage images, which post-processing needs
+	bool swapchainStorage = false;
 
 		// synch objects
 	std::vector<VkSemaphore> imagesAvailable;
 	std::vector<VkSemaphore> rendersFinished;
+	// graphics to compute handover of a frame with a compute submit, fence path only
+	std::vector<VkSemaphore> graphicsFinished;
 	std::vector<VkFence> drawFences;
+	// with timeline sync one timeline per queue replaces drawFences and graphicsFinished; the
+	// compute submit waits for the frame's graphics value
+	bool useTimelineSync = false;
+	TimelineSemaphore graphicsTimeline;
+	TimelineSemaphore computeTimeline;
+
+		// frame serials, one per graphics submit; equal to the graphics timeline value with timeline sync
+	uint64_t lastSubmittedSerial = 0;
+	uint64_t completedSerial = 0;
+	std::array<uint64_t, MaxFrameDraws> frameSerials {};
+	// compute timeline value a frame is complete at, the last one submitted up to that frame
+	std::array<uint64_t, MaxFrameDraws> frameComputeValues {};
+	DeletionQueue deletionQueue;
 
+		// frame timing
+	FramePacer* framePacer = nullptr;
+	std::array<std::chrono::steady_clock::time_point, MaxFrameDraws> frameStartTimes;
+	// taken by Update, only stored per slot after Draw has waited for the slot's previous frame
+	std::chrono::steady_clock::time_point nextFrameStart;
+	bool nextFrameStartSet = false;
+	std::array<bool, MaxFrameDraws> framesInFlight {};
+
+		// transient CPU data of each frame in flight, reset once the frame has completed
+	std::array<FrameArena, MaxFrameDraws> frameArenas;
+	// one draw as recorded, resolved from its DrawCommand before recording starts
+	struct DrawPacket {
+		VkPipeline pipeline;
+		uint32_t vertexCount;
+		uint32_t instanceCount;
+		uint32_t firstVertex;
+		DrawIndices indices;
+	};
+
+	// scene
+	std::vector<DrawCommand> drawCommands;
+	std::vector<uint32_t> visibleDraws;
+	FrustumCuller frustumCuller;
+	unsigned int cullingThreadCount = 1;
+
+
+	int InitVulkan ();
+	void DestroyDeviceObjects ();
 
 	// vk functions
 	void CreateInstance ();
 	void CreateLogicalDevice ();
 	void CreateSurface ();
-	void CreateSwapchain ();
+	void CreateSwapchain (VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+	void CreateOffscreenTargets ();
 	void CreateRenderPass ();
+	void CreateBindlessHeap ();
 	void CreateGraphicsPipeline ();
+	uint32_t FindOrAddGraphicsPipeline (GraphicsPipeline graphicsPipeline);
+	VkPipeline CreateGraphicsPipelineVariant (const GraphicsPipeline& description, VkShaderModule vertexModule, VkShaderModule fragmentModule);
+	void CreateComputePipelines ();
+	VkPipeline CreateComputePipeline (const ComputePipeline& description, VkShaderModule shaderModule);
+	uint32_t FindOrAddShaderModule (const std::string& fileName);
+	void CreateComputeDescriptorPool ();
+	void CreatePostProcessDescriptors ();
 	void CreateFrameBuffers ();
 	void CreateCommandPool ();
 	void CreateCommandBuffers ();
 	void CreateSynchronization ();
+	void CreateBuffer (VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+					   VkBuffer& buffer, VkDeviceMemory& memory);
+	void DestroyUploadBuffers ();
+	void CreateReadbackBuffers ();
+	void DestroyReadbackBuffers ();
+	int AcquireReadbackSlot ();
+	VkCommandBuffer BeginOneTimeCommands ();
+	void EndOneTimeCommands (VkCommandBuffer commandBuffer);
 
 	// get methods
 	void GetPhysicalDevice ();
+	void CacheDeviceData ();
 	QueueFamilyIndices GetQueueFamilies (VkPhysicalDevice device);
 	SwapchainDetails GetSwapchainDetails (VkPhysicalDevice device);
 
+	// frame functions
+	bool IsFrameComplete (int frame);
+	void WaitForFrame (int frame);
+	void PollCompletedFrames ();
+	uint64_t GetCompletedSerial ();
+
 	// record functions
-	void RecordCommands ();
+	void RecordCommands (uint32_t imageIndex);
+	// the compute queue dispatches, then the post-process when enabled
+	void RecordComputeCommands (uint32_t imageIndex);
+	void RecordDispatches (VkCommandBuffer commandBuffer, ComputeQueue queue);
+	void RecordDispatch (VkCommandBuffer commandBuffer, const ComputeDispatch& dispatch);
+	bool UsesComputeSubmit () const { return postProcessEnabled || computeQueueDispatchCount != 0; }
+	// returns the value signaled on the queue's timeline, 0 on the fence path
+	uint64_t SubmitFrame (VkQueue queue, TimelineSemaphore& timeline, VkCommandBuffer commandBuffer,
+						  VkSemaphore waitSemaphore, uint64_t waitValue, VkPipelineStageFlags waitStage, bool lastSubmit);
+	void RecordReadback (VkCommandBuffer commandBuffer, uint32_t imageIndex, const ReadbackSlot& readbackSlot);
 
 	// util functions
 	bool CheckInstanceExtensionSupport (const std::vector<const char*>* checkExtensions);
 	bool CheckDeviceExtensionSupport (VkPhysicalDevice device);
 	bool CheckDeviceSuitable (VkPhysicalDevice device);
+	bool GetVulkan12Features (VkPhysicalDevice device, VkPhysicalDeviceVulkan12Features& vulkan12Features);
+	bool CheckTimelineSupport (VkPhysicalDevice device);
+	bool CheckBindlessSupport (VkPhysicalDevice device);
+	bool CheckStorageSupport (VkFormat format);
 
 	VkSurfaceFormatKHR ChooseBestSurfaceFormat (const std::vector<VkSurfaceFormatKHR>& formats);
 	VkPresentModeKHR ChooseBestPresentationMode (const std::vector<VkPresentModeKHR>& presentationModes);
 	VkExtent2D ChooseSwapExtent (const VkSurfaceCapabilitiesKHR& surfaceCapabilities);
 
+	uint32_t FindMemoryTypeIndex (uint32_t allowedTypes, VkMemoryPropertyFlags properties);
+
 	VkImageView CreateImageView (VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-	VkShaderModule CreateShaderModule (const std::vector<char>& code);
+	VkShaderModule CreateShaderModule (const uint32_t* code, size_t codeSize);
 };
 
 
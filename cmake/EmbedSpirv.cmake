@@ -0,0 +1,25 @@
+# Turns a SPIR-V binary into a header with an aligned constexpr uint32_t array.
+# Run in script mode: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DSYMBOL=<name> -DSOURCE=<glsl> -P EmbedSpirv.cmake
+
+file(READ "${INPUT}" spirv HEX)
+string(LENGTH "${spirv}" hexLength)
+math(EXPR wordRemainder "${hexLength} % 8")
+if (hexLength EQUAL 0 OR NOT wordRemainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a SPIR-V module")
+endif()
+
+# SPIR-V words are little endian in the file
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " words "${spirv}")
+# eight words per line
+set(word "0x........u, ")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n\t" words "${words}")
+string(REPLACE " \n" "\n" words "${words}")
+string(REGEX REPLACE "[ \t\n]+$" "" words "${words}")
+
+get_filename_component(sourceName "${SOURCE}" NAME)
+
+set(header "// generated from ${sourceName} by EmbedSpirv.cmake, do not edit\n")
+string(APPEND header "#pragma once\n\n#include <cstdint>\n\n")
+string(APPEND header "alignas(4) inline constexpr uint32_t ${SYMBOL}[] = {\n\t${words}\n};\n")
+
+file(WRITE "${OUTPUT}" "${header}")
@@ -1,21 +1,48 @@
-#include <iostream>
+#include <atomic>
+#include <cstdlib>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include "VulkanRenderer.h"
+#include "FramePacer.h"
+#include "ShaderWatcher.h"
+#include "FrameCapture.h"
+#include "AsyncLogger.h"
+#include "SpscQueue.h"
+
+// window input as the render thread receives it
+struct InputEvent {
+	int key;
+	int action;
+	int mods;
+};
 
 GLFWwindow* mainWindow;
 VulkanRenderer vkRenderer;
+FramePacer framePacer;
+ShaderWatcher shaderWatcher;
+FrameCaptureWriter captureWriter;
+
+// the main thread only pumps window events, everything that touches the renderer runs on
+// renderThread; input crosses over through inputQueue without either side waiting
+std::thread renderThread;
+std::atomic<bool> rendering {false};
+std::atomic<bool> renderFailed {false};
+SpscQueue<InputEvent, 256> inputQueue;
+uint64_t droppedInputEvents = 0;
 
 static void HandleKeyboardInput (GLFWwindow* window, int key, int status, int action, int mods)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
 		glfwSetWindowShouldClose (window, GLFW_TRUE);
-	} else {
-		std::cout << "Key> " << key << std::endl;
+	} else if (!inputQueue.TryPush ({key, action, mods})) {
+		// only when the render thread has been stuck for hundreds of events
+		++droppedInputEvents;
 	}
 }
 
@@ -30,23 +57,137 @@ static void InitWindow (const std::string& windowTitle = "Default title", const
 	glfwSetKeyCallback (mainWindow, HandleKeyboardInput);
 }
 
+static double GetTargetFrameRate ()
+{
+	const char* targetFrameRate = std::getenv ("VULKAN_TARGET_FPS");
+	return targetFrameRate != nullptr ? std::atof (targetFrameRate) : 60.0;
+}
+
+static bool IsShaderReloadEnabled ()
+{
+	const char* shaderReload = std::getenv ("VULKAN_SHADER_RELOAD");
+	return shaderReload == nullptr || std::string (shaderReload) != "0";
+}
+
+// VULKAN_CAPTURE=png:<dir>, raw:<dir> or pipe:<command>, e.g.
+// "pipe:ffmpeg -f rawvideo -pix_fmt rgba -s 600x600 -i - capture.mp4"
+static void StartFrameCapture ()
+{
+	const char* capture = std::getenv ("VULKAN_CAPTURE");
+	if (capture == nullptr) {
+		return;
+	}
+
+	std::string setting = capture;
+	size_t separator = setting.find (':');
+	std::string kind = setting.substr (0, separator);
+	std::string target = separator == std::string::npos ? "." : setting.substr (separator + 1);
+
+	CaptureOutput output;
+	if (kind == "png") {
+		output = CaptureOutput::Png;
+	} else if (kind == "raw") {
+		output = CaptureOutput::Raw;
+	} else if (kind == "pipe") {
+		output = CaptureOutput::Pipe;
+	} else {
+		Log (LogStream::Error, "Capture> unknown output ", kind, ", use png, raw or pipe");
+		return;
+	}
+
+	if (captureWriter.Start (output, target)) {
+		vkRenderer.SetFrameCaptureWriter (&captureWriter);
+	}
+}
+
+static void ApplyShaderReloads ()
+{
+	static std::vector<ShaderReload> shaderReloads;
+
+	shaderReloads.clear ();
+	if (shaderWatcher.PollReloads (shaderReloads)) {
+		for (const auto& shaderReload : shaderReloads) {
+			vkRenderer.ReloadShaderModule (shaderReload.fileName, shaderReload.code);
+		}
+	}
+}
+
+static void HandleInputEvent (const InputEvent& inputEvent)
+{
+	Log (LogStream::Out, "Key> ", inputEvent.key);
+}
+
+static void RenderLoop ()
+{
+	try {
+		InputEvent inputEvent;
+		while (rendering.load (std::memory_order_acquire)) {
+			framePacer.WaitForNextFrame ();
+			while (inputQueue.TryPop (inputEvent)) {
+				HandleInputEvent (inputEvent);
+			}
+			// between two frames, so no command buffer is being recorded with the old pipelines
+			ApplyShaderReloads ();
+			vkRenderer.Update ();
+			vkRenderer.Draw ();
+		}
+	} catch (const std::exception& exception) {
+		// anything escaping the thread would terminate without the renderer being cleaned up
+		Log (LogStream::Error, "Error: ", exception.what ());
+		renderFailed = true;
+		// both may be called from any thread, the empty event wakes glfwWaitEvents
+		glfwSetWindowShouldClose (mainWindow, GLFW_TRUE);
+		glfwPostEmptyEvent ();
+	}
+}
+
 int main ()
 {
+	GetLogger ().Start ();
 	InitWindow ("MoltenVK window", 600, 600);
 
 	if (vkRenderer.InitRenderer (mainWindow) == EXIT_FAILURE) {
+		GetLogger ().Stop ();
 		return EXIT_FAILURE;
 	}
 
+	framePacer.SetTargetFrameRate (GetTargetFrameRate ());
+	vkRenderer.SetFramePacer (&framePacer);
+
+	if (IsShaderReloadEnabled ()) {
+		shaderWatcher.Start (ShaderDirectory);
+	}
+
+	try {
+		StartFrameCapture ();
+	} catch (const std::runtime_error& runtimeError) {
+		Log (LogStream::Error, "Error: ", runtimeError.what ());
+	}
+
+	rendering = true;
+	renderThread = std::thread (RenderLoop);
+
+	// sleeps until the window system has something, a fence wait or present never delays input
 	while (!glfwWindowShouldClose (mainWindow)) {
-		glfwPollEvents ();
-		vkRenderer.Draw ();
+		glfwWaitEvents ();
 	}
 
+	rendering = false;
+	renderThread.join ();
+
+	shaderWatcher.Stop ();
 	vkRenderer.CleanUp ();
+	captureWriter.Stop ();
+	if (vkRenderer.GetDroppedCaptureCount () > 0) {
+		Log (LogStream::Out, "Capture> dropped ", vkRenderer.GetDroppedCaptureCount (), " frames");
+	}
+	if (droppedInputEvents > 0) {
+		Log (LogStream::Out, "Input> dropped ", droppedInputEvents, " events");
+	}
 
 	glfwDestroyWindow (mainWindow);
 	glfwTerminate ();
+	GetLogger ().Stop ();
 
-	return 0;
+	return renderFailed ? EXIT_FAILURE : 0;
 }